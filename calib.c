@@ -0,0 +1,93 @@
+#include "calib.h"
+
+/* Identity calibration, not running */
+void calib_reset(MagCalib *cal) {
+    memset(cal, 0, sizeof(*cal));
+    for (uint8_t i = 0; i < 3; i++) {
+        cal->scale[i] = CAL_SCALE_ONE;
+    }
+}
+
+/* Start a new min/max envelope */
+void calib_start(MagCalib *cal) {
+    for (uint8_t i = 0; i < 3; i++) {
+        cal->min[i] = INT16_MAX;
+        cal->max[i] = INT16_MIN;
+    }
+    cal->samples = 0;
+    cal->running = true;
+}
+
+/* Widen the envelope with a raw sample */
+void calib_update(MagCalib *cal, MagRaw sample) {
+    int16_t axis[3] = { sample.x, sample.y, sample.z };
+    
+    if (!cal->running) {
+        return;
+    }
+    for (uint8_t i = 0; i < 3; i++) {
+        if (axis[i] < cal->min[i]) cal->min[i] = axis[i];
+        if (axis[i] > cal->max[i]) cal->max[i] = axis[i];
+    }
+    if (cal->samples < UINT16_MAX) {
+        cal->samples++;
+    }
+}
+
+/* Stop collecting and turn the envelope into offsets and scales */
+bool calib_stop(MagCalib *cal) {
+    int32_t radius[3];
+    int32_t radius_sum = 0;
+    uint8_t swept = 0;
+    
+    if (!cal->running) {
+        return false;
+    }
+    cal->running = false;
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        int32_t span = (int32_t)cal->max[i] - cal->min[i];
+        radius[i] = (span >= CAL_MIN_SPAN) ? span / 2 : 0;
+        if (radius[i] > 0) {
+            radius_sum += radius[i];
+            swept++;
+        }
+    }
+    if (radius[0] == 0 || radius[1] == 0) {
+        return false;  // Heading axes not swept, keep the old calibration
+    }
+    
+    int32_t mean = radius_sum / swept;
+    for (uint8_t i = 0; i < 3; i++) {
+        if (radius[i] == 0) {
+            continue;
+        }
+        cal->offset[i] = (int16_t)(((int32_t)cal->max[i] + cal->min[i]) / 2);
+        
+        int32_t scale = (mean * CAL_SCALE_ONE + radius[i] / 2) / radius[i];
+        cal->scale[i] = (scale > CAL_SCALE_MAX) ? CAL_SCALE_MAX : (uint16_t)scale;
+    }
+    return true;
+}
+
+/* Remove the offset, apply the scale and saturate to int16 */
+static int16_t calib_axis(int16_t raw, int16_t offset, uint16_t scale) {
+    int32_t value = ((int32_t)raw - offset) * scale;
+    
+    // Round half away from zero
+    value = (value >= 0) ? (value + CAL_SCALE_ONE / 2) >> CAL_SCALE_SHIFT
+                         : -((CAL_SCALE_ONE / 2 - value) >> CAL_SCALE_SHIFT);
+    if (value > INT16_MAX) return INT16_MAX;
+    if (value < INT16_MIN) return INT16_MIN;
+    return (int16_t)value;
+}
+
+/* Corrected sample */
+MagRaw calib_apply(const MagCalib *cal, MagRaw sample) {
+    MagRaw out;
+    
+    out.x = calib_axis(sample.x, cal->offset[0], cal->scale[0]);
+    out.y = calib_axis(sample.y, cal->offset[1], cal->scale[1]);
+    out.z = calib_axis(sample.z, cal->offset[2], cal->scale[2]);
+    return out;
+}
@@ -0,0 +1,56 @@
+/*
+ * File:   calib.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 6:45 PM
+ */
+
+#ifndef CALIB_H
+#define	CALIB_H
+
+#include "spi.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Soft-iron scale format: Q2.14, CAL_SCALE_ONE = 1.0
+#define CAL_SCALE_SHIFT 14
+#define CAL_SCALE_ONE   (1L << CAL_SCALE_SHIFT)
+#define CAL_SCALE_MAX   (2 * CAL_SCALE_ONE)   // Keeps (raw - offset) * scale within int32
+
+// Smallest max-min span (raw counts) for an axis to be calibrated, ~50 LSB
+#define CAL_MIN_SPAN    (50 * MAG_RAW_SCALE)
+
+/*
+ * Streaming hard/soft-iron calibration
+ *
+ * While running, every raw sample widens the per-axis min/max envelope
+ * (O(1) memory, no sample log). Stopping turns the envelope into:
+ *   offset[i] = (max + min) / 2                  hard iron, raw counts
+ *   scale[i]  = mean radius / ((max - min) / 2)  soft iron (axis-aligned), Q2.14
+ * Only axes swept by at least CAL_MIN_SPAN are updated and enter the mean
+ * radius; x and y are required since they carry the yaw. Rotate the board
+ * through full turns while calibrating.
+ */
+typedef struct {
+    bool running;                // Collecting min/max
+    uint16_t samples;            // Samples seen in the current run
+    int16_t min[3];              // Envelope of the current run (raw counts)
+    int16_t max[3];
+    int16_t offset[3];           // Applied hard-iron offset (raw counts)
+    uint16_t scale[3];           // Applied soft-iron scale (Q2.14)
+} MagCalib;
+
+/* Calibration Functions */
+void calib_reset(MagCalib *cal);                    // Identity calibration, not running
+void calib_start(MagCalib *cal);                    // Start a new envelope, current correction stays applied
+bool calib_stop(MagCalib *cal);                     // Stop and apply, false if x/y were not swept
+void calib_update(MagCalib *cal, MagRaw sample);    // Feed a raw sample, O(1)
+MagRaw calib_apply(const MagCalib *cal, MagRaw sample);  // Corrected sample (saturated to int16)
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CALIB_H */
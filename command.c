@@ -0,0 +1,70 @@
+#include "command.h"
+
+/* Dispatch counters */
+CommandStats command_stats;
+
+/* Pack a message type into its command key */
+uint32_t command_key(const char *type) {
+    uint32_t key = 0;
+    bool done = false;
+    
+    for (uint8_t i = 0; i < 5; i++) {
+        char c = done ? '\0' : type[i];
+        if (c == '\0') {
+            done = true;  // Pad the remaining characters with 0
+        } else if (c < 0x21 || c > 0x5F) {
+            return CMD_KEY_INVALID;
+        }
+        key = (key << 6) | CMD_CODE(c);
+    }
+    
+    if (!done && type[5] != '\0') {
+        return CMD_KEY_INVALID;  // More than 5 characters
+    }
+    return key;
+}
+
+/* Collect the field offsets recorded by the parser */
+static void command_tokenise(const parser_state *ps, CommandArgs *args) {
+    int len;
+    
+    args->count = 0;
+    while (args->count < CMD_MAX_ARGS) {
+        const char *field = parser_field(ps, args->count, &len);
+        if (field == NULL) {
+            break;
+        }
+        args->field[args->count] = field;
+        args->len[args->count] = len;
+        args->count++;
+    }
+}
+
+/* Look up the handler for a parsed message, run it and reply */
+void command_dispatch(const CommandEntry *table, uint8_t count, const parser_state *ps) {
+    uint32_t key = command_key(ps->msg_type);
+    CommandResult result = CMD_ERR_UNKNOWN;
+    char reply[sizeof("$ACK,") + PARSER_TYPE_SIZE + sizeof("*")];  // Longest type, $ERR,255* is shorter
+    
+    for (uint8_t i = 0; i < count; i++) {
+        if (table[i].key == key) {
+            CommandArgs args;
+            command_tokenise(ps, &args);
+            result = (args.count < table[i].min_args) ? CMD_ERR_ARGS
+                                                      : table[i].handler(&args);
+            break;
+        }
+    }
+    
+    if (result == CMD_OK) {
+        command_stats.handled++;
+        snprintf(reply, sizeof(reply), "$ACK,%s*", ps->msg_type);
+    } else {
+        if (result == CMD_ERR_UNKNOWN) {
+            command_stats.unknown++;
+        }
+        command_stats.rejected++;
+        snprintf(reply, sizeof(reply), "$ERR,%u*", (uint8_t)result);
+    }
+    UART1_SendString(reply);
+}
@@ -0,0 +1,73 @@
+/*
+ * File:   command.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 2:40 PM
+ */
+
+#ifndef COMMAND_H
+#define	COMMAND_H
+
+#include "uart.h"
+#include "parser.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define CMD_MAX_ARGS PARSER_MAX_FIELDS  // Payload fields passed to a handler
+
+/*
+ * Message types are packed 6 bits per character ('!'..'_' -> 1..63,
+ * missing characters -> 0) into a 30-bit key. The packing is injective,
+ * so a key match is an exact type match and lookup needs no strcmp.
+ * Use CMD_KEY('R','A','T','E',0) to build table keys at compile time.
+ */
+#define CMD_CODE(c)  ((uint32_t)((c) ? ((c) - 0x20) & 0x3F : 0))
+#define CMD_KEY(a, b, c, d, e) \
+    ((CMD_CODE(a) << 24) | (CMD_CODE(b) << 18) | (CMD_CODE(c) << 12) | \
+     (CMD_CODE(d) << 6) | CMD_CODE(e))
+#define CMD_KEY_INVALID 0xFFFFFFFFUL  // Type too long or has unsupported characters
+
+// Handler results: 0 sends $ACK,TYPE*, anything else $ERR,n*
+typedef enum {
+    CMD_OK = 0,
+    CMD_ERR_VALUE = 1,     // Argument out of range
+    CMD_ERR_UNKNOWN = 2,   // No handler for this type
+    CMD_ERR_ARGS = 3       // Wrong number of arguments
+} CommandResult;
+
+// Tokenised payload handed to a handler (views into parser_state.msg_payload)
+typedef struct {
+    uint8_t count;                      // Number of fields
+    const char *field[CMD_MAX_ARGS];    // Field start, ends at ',' or '\0'
+    uint8_t len[CMD_MAX_ARGS];          // Field length
+} CommandArgs;
+
+typedef CommandResult (*CommandHandler)(const CommandArgs *args);
+
+// Registry entry
+typedef struct {
+    uint32_t key;              // CMD_KEY of the message type
+    uint8_t min_args;          // Fewer fields -> CMD_ERR_ARGS
+    CommandHandler handler;
+} CommandEntry;
+
+// Dispatch counters
+typedef struct {
+    uint16_t handled;          // Commands acknowledged
+    uint16_t rejected;         // Commands answered with $ERR (including unknown)
+    uint16_t unknown;          // Types with no handler
+} CommandStats;
+
+extern CommandStats command_stats;
+
+/* Command Functions */
+uint32_t command_key(const char *type);  // Runtime equivalent of CMD_KEY
+void command_dispatch(const CommandEntry *table, uint8_t count, const parser_state *ps);
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* COMMAND_H */
@@ -14,6 +14,7 @@
 #include "stdio.h"     
 #include "string.h"     
 #include "stddef.h"  
+#include "stdarg.h"
 
 #ifdef __cplusplus
 extern "C" { 
@@ -25,13 +26,22 @@ extern "C" {
 // Timing intervals
 #define TIMER1_PERIOD_MS      10    // Main system tick interval
 #define LED_BLINK_INTERVAL_MS 500   // LED toggle interval 
-#define DATA_READ_INTERVAL    400   // Data reading interval
+#define DATA_READ_INTERVAL    40    // Data reading interval (25 Hz ODR)
+#define IMU_READ_INTERVAL_MS  20    // Accelerometer / gyroscope read interval
 #define YAW_SEND_INTERVAL_MS  200   // Yaw data transmission interval
+#define ISR_REPORT_INTERVAL_MS 1000 // TX ISR rate report interval
+#define CPU_REPORT_INTERVAL_MS 1000 // CPU / SPI load report interval
     
 // Derived counts
 #define DATA_READ_TICKS (DATA_READ_INTERVAL/TIMER1_PERIOD_MS)       // SPI datat read tick rate
+#define IMU_READ_TICKS  (IMU_READ_INTERVAL_MS / TIMER1_PERIOD_MS)  // Accel / gyro read tick rate
 #define LED_BLINK_TICKS (LED_BLINK_INTERVAL_MS / TIMER1_PERIOD_MS)  // LED blink tick rate
 #define YAW_SEND_TICKS  (YAW_SEND_INTERVAL_MS / TIMER1_PERIOD_MS)   // YAW send tick rate
+#define ISR_REPORT_TICKS (ISR_REPORT_INTERVAL_MS / TIMER1_PERIOD_MS) // ISR report tick rate
+#define CPU_REPORT_TICKS (CPU_REPORT_INTERVAL_MS / TIMER1_PERIOD_MS) // CPU load report tick rate
+
+/* Compile-time check: fails the build with a negative array size */
+#define STATIC_ASSERT(cond, name) typedef char static_assert_##name[(cond) ? 1 : -1]
 
 /* Hardware Pin Mapping */
 // LEDs
@@ -42,7 +52,7 @@ extern "C" {
 #define BUTTON2 PORTEbits.RE9 // Button 2 definition
 
 /* System Initialization */
-void config_init();  // Initialize clock, ports, peripherals
+bool config_init();  // Initialize clock, ports, peripherals, false if UART1 could not start
 
 #ifdef	__cplusplus
 }
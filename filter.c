@@ -0,0 +1,111 @@
+#include "filter.h"
+
+/* Select the filter and window, restarting from an empty history */
+bool filter_config(MagFilter *f, uint8_t type, uint8_t window) {
+    if (type >= FILTER_COUNT || window < 1 || window > FILTER_WINDOW_MAX) {
+        return false;
+    }
+    memset(f, 0, sizeof(*f));
+    f->type = type;
+    f->window = window;
+    return true;
+}
+
+/* Add a sample: history slot, running sum and EMA are updated in O(1) */
+void filter_update(MagFilter *f, MagRaw sample) {
+    int16_t axis[3] = { sample.x, sample.y, sample.z };
+    
+    // Warm-up: the EMA averages all samples so far until the window is full
+    uint8_t n = (f->count < f->window) ? f->count + 1 : f->window;
+    
+    for (uint8_t i = 0; i < 3; i++) {
+        if (f->count == f->window) {
+            f->sum[i] -= f->history[i][f->idx];  // Oldest sample leaves the window
+        }
+        f->history[i][f->idx] = axis[i];
+        f->sum[i] += axis[i];
+        
+        int32_t q16 = (int32_t)axis[i] * (65536 / MAG_RAW_SCALE);
+        f->ema[i] += (q16 - f->ema[i]) / n;
+    }
+    
+    f->idx = (f->idx + 1 < f->window) ? f->idx + 1 : 0;
+    f->count = n;
+    f->cached = false;
+}
+
+/* Average of n raw samples with sum sum, in sensor LSB */
+static mag_value_t filter_mean(int32_t sum, uint8_t n) {
+#if MAG_INTEGER_PIPELINE
+    // Q16.16: sum * 65536 / (MAG_RAW_SCALE * n), rounded half away from zero
+    int32_t scaled = sum * (65536 / MAG_RAW_SCALE);
+    int32_t q = scaled / n;
+    int32_t r = scaled % n;
+    if (2 * (r < 0 ? -r : r) >= n) {
+        q += (r < 0) ? -1 : 1;
+    }
+    return q;
+#else
+    return (float)sum / ((int16_t)MAG_RAW_SCALE * n);
+#endif
+}
+
+/* Median of the history of one axis (insertion sort, n <= FILTER_WINDOW_MAX) */
+static mag_value_t filter_median(const int16_t *history, uint8_t n) {
+    int16_t sorted[FILTER_WINDOW_MAX];
+    
+    for (uint8_t i = 0; i < n; i++) {
+        int16_t v = history[i];
+        uint8_t j = i;
+        while (j > 0 && sorted[j - 1] > v) {
+            sorted[j] = sorted[j - 1];
+            j--;
+        }
+        sorted[j] = v;
+    }
+    
+    // Even count: mean of the two middle samples
+    if ((n & 1) == 0) {
+        return filter_mean((int32_t)sorted[n / 2 - 1] + sorted[n / 2], 2);
+    }
+    return filter_mean(sorted[n / 2], 1);
+}
+
+/* Convert EMA state to the output type */
+static mag_value_t filter_ema(int32_t ema) {
+#if MAG_INTEGER_PIPELINE
+    return ema;
+#else
+    return (float)ema / 65536.0f;
+#endif
+}
+
+/* Filtered data, computed at most once per sample */
+MagData filter_output(MagFilter *f) {
+    if (f->cached) {
+        return f->out;
+    }
+    
+    mag_value_t value[3] = { 0, 0, 0 };
+    if (f->count > 0) {
+        for (uint8_t i = 0; i < 3; i++) {
+            switch (f->type) {
+                case FILTER_EMA:
+                    value[i] = filter_ema(f->ema[i]);
+                    break;
+                case FILTER_MEDIAN:
+                    value[i] = filter_median(f->history[i], f->count);
+                    break;
+                default:
+                    value[i] = filter_mean(f->sum[i], f->count);
+                    break;
+            }
+        }
+    }
+    
+    f->out.x = value[0];
+    f->out.y = value[1];
+    f->out.z = value[2];
+    f->cached = true;
+    return f->out;
+}
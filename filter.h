@@ -0,0 +1,66 @@
+/*
+ * File:   filter.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 5:20 PM
+ */
+
+#ifndef FILTER_H
+#define	FILTER_H
+
+#include "spi.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Filter types ($FILT,type,window*)
+typedef enum {
+    FILTER_BOXCAR = 0,     // Moving average over the last window samples
+    FILTER_EMA,            // Exponential average, alpha = 1/window
+    FILTER_MEDIAN,         // Median of the last window samples
+    FILTER_COUNT
+} FilterType;
+
+// Sample history per axis, largest selectable window
+#define FILTER_WINDOW_MAX 8
+
+// Build-time defaults
+#ifndef MAG_FILTER_TYPE
+#define MAG_FILTER_TYPE   FILTER_BOXCAR
+#endif
+#ifndef MAG_FILTER_WINDOW
+#define MAG_FILTER_WINDOW 5
+#endif
+
+STATIC_ASSERT(MAG_FILTER_WINDOW >= 1 && MAG_FILTER_WINDOW <= FILTER_WINDOW_MAX, mag_filter_window_valid);
+// Window sums of raw values, scaled to Q16.16, must fit in int32
+STATIC_ASSERT(FILTER_WINDOW_MAX * 32768UL <= 0x80000000UL / (65536 / MAG_RAW_SCALE), filter_window_sum_fits);
+
+/*
+ * Magnetometer filter state, zero-initialise with type and window set.
+ * Until window samples have arrived every filter works on the samples it
+ * has, so start-up does not average in empty slots.
+ */
+typedef struct {
+    uint8_t type;                        // FilterType
+    uint8_t window;                      // 1..FILTER_WINDOW_MAX
+    uint8_t idx;                         // Next history slot
+    uint8_t count;                       // Samples in the history (<= window)
+    int16_t history[3][FILTER_WINDOW_MAX];  // Raw samples per axis (boxcar, median)
+    int32_t sum[3];                      // Running sum of the history (boxcar)
+    int32_t ema[3];                      // EMA state, Q16.16 sensor LSB
+    bool cached;                         // out is up to date
+    MagData out;                         // Last computed output
+} MagFilter;
+
+/* Filter Functions */
+bool filter_config(MagFilter *f, uint8_t type, uint8_t window);  // Select filter and restart, false if invalid
+void filter_update(MagFilter *f, MagRaw sample);                 // Add a sample, O(1)
+MagData filter_output(MagFilter *f);                             // Filtered data, cached until the next sample
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FILTER_H */
@@ -0,0 +1,97 @@
+#include "format.h"
+
+/* Write sign and magnitude in hundredths as [-]I.FF */
+uint8_t fmt_fixed2(char *out, bool negative, uint32_t centi) {
+    char digits[8];
+    uint8_t count = 0;
+    uint8_t len = 0;
+    uint32_t whole = centi / 100;
+    uint8_t frac = (uint8_t)(centi - whole * 100);
+    
+    if (negative) {
+        out[len++] = '-';
+    }
+    
+    // Integer digits, least significant first (16-bit division once it fits)
+    while (whole > 0xFFFF) {
+        digits[count++] = '0' + (uint8_t)(whole % 10);
+        whole /= 10;
+    }
+    uint16_t small = (uint16_t)whole;
+    do {
+        digits[count++] = '0' + (uint8_t)(small % 10);
+        small /= 10;
+    } while (small != 0);
+    
+    while (count > 0) {
+        out[len++] = digits[--count];
+    }
+    out[len++] = '.';
+    out[len++] = '0' + frac / 10;
+    out[len++] = '0' + frac % 10;
+    out[len] = '\0';
+    return len;
+}
+
+/* Format a value given in hundredths */
+uint8_t fmt_centi(char *out, int32_t centi) {
+    bool negative = (centi < 0);
+    return fmt_fixed2(out, negative, negative ? 0U - (uint32_t)centi : (uint32_t)centi);
+}
+
+/* Format a Q16.16 value, rounding the 16 fraction bits to hundredths */
+uint8_t fmt_q16(char *out, int32_t q16) {
+    bool negative = (q16 < 0);
+    uint32_t mag = negative ? 0U - (uint32_t)q16 : (uint32_t)q16;
+    uint32_t scaled = (mag & 0xFFFF) * 100;       // Fraction in 1/2^16 hundredths
+    uint32_t centi = (mag >> 16) * 100 + (scaled >> 16);
+    uint16_t rem = (uint16_t)scaled;
+    
+    // Round half to even on the exact remainder
+    if (rem > 0x8000 || (rem == 0x8000 && (centi & 1))) {
+        centi++;
+    }
+    return fmt_fixed2(out, negative, centi);
+}
+
+/* Format a float from its IEEE-754 fields, no floating point operations */
+uint8_t fmt_float(char *out, float value) {
+    union { float f; uint32_t u; } bits = { .f = value };
+    bool negative = (bits.u >> 31) != 0;
+    int16_t exp = (int16_t)((bits.u >> 23) & 0xFF);
+    uint32_t mant = bits.u & 0x7FFFFF;
+    uint32_t centi;
+    
+    if (exp == 0xFF) {
+        return 0;                 // NaN or Inf
+    }
+    if (exp == 0) {
+        exp = 1;                  // Subnormal
+    } else {
+        mant |= 0x800000;         // Implicit leading one
+    }
+    
+    // value * 100 = n * 2^exp exactly, n < 2^31
+    uint32_t n = mant * 100;
+    exp -= 150;
+    
+    if (exp >= 0) {
+        if (exp >= 32 || n > (0xFFFFFFFFUL >> exp)) {
+            return 0;             // Too large for 32-bit hundredths
+        }
+        centi = n << exp;
+    } else if (exp > -32) {
+        uint8_t shift = (uint8_t)-exp;
+        uint32_t half = 1UL << (shift - 1);
+        uint32_t rem = n & ((half << 1) - 1);
+        
+        // Round half to even on the bits shifted out
+        centi = n >> shift;
+        if (rem > half || (rem == half && (centi & 1))) {
+            centi++;
+        }
+    } else {
+        centi = 0;                // Below 2^-32 * 100, rounds to zero
+    }
+    return fmt_fixed2(out, negative, centi);
+}
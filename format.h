@@ -0,0 +1,37 @@
+/*
+ * File:   format.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 4:05 PM
+ */
+
+#ifndef FORMAT_H
+#define	FORMAT_H
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Longest two-decimal number: "-42949672.95" + string terminator
+#define FMT_FIXED2_MAX 13
+
+/*
+ * Two-decimal formatters, integer arithmetic only
+ *
+ * Each writes a signed "[-]I.FF" string plus terminator to out (at least
+ * FMT_FIXED2_MAX bytes) and returns its length. The output is the same as
+ * printf("%.2f") for the same value: the exact value is rounded half to
+ * even, and a negative value that rounds to zero prints as "-0.00".
+ */
+uint8_t fmt_fixed2(char *out, bool negative, uint32_t centi);  // Sign + magnitude in hundredths
+uint8_t fmt_centi(char *out, int32_t centi);                    // Value in hundredths
+uint8_t fmt_q16(char *out, int32_t q16);                        // Q16.16 value
+uint8_t fmt_float(char *out, float value);                      // Returns 0 for NaN, Inf or |value| >= 2^32 / 100
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FORMAT_H */
@@ -0,0 +1,39 @@
+#include "health.h"
+
+HealthStats health;
+
+/* Account one tick, missed is the number of ticks that passed before the wait */
+void health_tick(uint8_t missed) {
+    health.ticks++;
+    if (missed == 0) {
+        health.overrun_run = 0;
+        return;
+    }
+
+    // Every tick that passed unserved is a miss, saturating
+    health.misses = (UINT16_MAX - health.misses < missed) ? UINT16_MAX : health.misses + missed;
+    if (health.overrun_run != UINT16_MAX) {
+        health.overrun_run++;
+    }
+    if (health.overrun_run > health.overrun_run_max) {
+        health.overrun_run_max = health.overrun_run;
+    }
+
+    uint32_t late = tmr_tick_late();
+    if (late > health.worst_late) {
+        health.worst_late = late;
+    }
+}
+
+/* Build $STAT,ticks,miss,run,late_us,rx_ovf,tx_ovf,oerr,parse,rej,mag_queued,mag_miss,mag_dup,mag_chip* */
+bool health_format(const parser_state *ps, char *out, uint16_t size) {
+    int len = snprintf(out, size, "$STAT,%lu,%u,%u,%lu,%u,%u,%u,%u,%u,%u,%u,%u,%u*",
+                       (unsigned long)health.ticks, health.misses, health.overrun_run_max,
+                       (unsigned long)(health.worst_late / TMR_CYCLES_PER_US),
+                       uart1_rx.overflow, uart1_tx.overflow, uart1_rx.oerr,
+                       ps->errors, command_stats.rejected,
+                       mag_stats.queued, mag_stats.missed, mag_stats.duplicate,
+                       (unsigned)mag_chip_state());
+
+    return len > 0 && len < size;
+}
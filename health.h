@@ -0,0 +1,48 @@
+/*
+ * File:   health.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 10:50 PM
+ */
+
+#ifndef HEALTH_H
+#define	HEALTH_H
+
+#include "spi.h"
+#include "command.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// $STAT,ticks,miss,run,late_us,rx_ovf,tx_ovf,oerr,parse,rej,mag_queued,mag_miss,mag_dup,mag_chip*
+// worst case: "$STAT" + ",ticks" 11 + 10 * ",uint16" 60 + ",late_us" 9 (UINT32_MAX cycles / 72)
+//             + ",2" + "*" + terminator = 5 + 11 + 60 + 9 + 2 + 1 + 1
+#define STAT_FRAME_WORST "$STAT,4294967295,65535,65535,59652323,65535,65535,65535,65535,65535,65535,65535,65535,2*"
+#define STAT_FRAME_MAX 89
+STATIC_ASSERT(sizeof(STAT_FRAME_WORST) == STAT_FRAME_MAX, stat_frame_max);
+
+/*
+ * Main loop timing health, updated once per tick by health_tick().
+ * The other $STAT counters live with their owners (UART rings, parser,
+ * command dispatcher, magnetometer queue) and are only read here.
+ */
+typedef struct {
+    uint32_t ticks;            // Ticks run
+    uint16_t misses;           // Ticks whose deadline was missed
+    uint16_t overrun_run;      // Current run of consecutive misses
+    uint16_t overrun_run_max;  // Longest run of consecutive misses
+    uint32_t worst_late;       // Worst lateness (cycles past the tick)
+} HealthStats;
+
+extern HealthStats health;
+
+/* Health Functions */
+void health_tick(uint8_t missed);                  // Result of tmr_tick_wait()
+bool health_format(const parser_state *ps, char *out, uint16_t size);  // $STAT frame
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HEALTH_H */
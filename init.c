@@ -2,8 +2,9 @@
 
 #include "SPI.h"
 
-/* Initial Configurations definitions */
-void config_init(){
+/* Initial Configurations definitions, false if UART1 could not be started */
+bool config_init(){
+    bool uart_ok;
     
     /* Disable analog functionality of all the pins */
     ANSELA = ANSELB = ANSELC = ANSELD = ANSELE = ANSELG = 0x0000;
@@ -35,15 +36,24 @@ void config_init(){
     RPINR0bits.INT1R = 0x58;    // Map RE8 to INT1
     RPINR1bits.INT2R = 0x59;    // Map RE9 to INT2  
     
+    // Magnetometer DRDY Remapping
+    RPINR1bits.INT3R = MAG_DRDY_RPI;  // Map DRDY pin to INT3
+    
     // SPI Remapping
     RPINR20bits.SDI1R = 0b00010001; // MISO = RP17  
     RPOR12bits.RP109R = 0b000101;   // MOSI = RF13  
     RPOR11bits.RP108R = 0b000110;   // SCK = RF12  
     
     /* Peripheral Initialization */
-    UART1_Init(BAUDRATE);   // Initialize UART1 at 115200 bps
+    uart_ok = UART1_Init(BAUDRATE);  // Initialize UART1 at 115200 bps, fails if FCY cannot reach it
+    tmr_cycles_init();      // Timestamps and SPI CS hold times
     spi_init();             // Initialize SPI peripheral
     mag_sleep();            // Sleep MAG
     mag_active();           // Wake up MAG 
+#if MAG_SAMPLING_DRDY
+    mag_drdy_enable();      // Read on every data-ready edge
+#endif
+    mag_config_flush();     // Power-up starts now, the main loop writes the rest once settled
     
+    return uart_ok;
 }
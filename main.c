@@ -6,131 +6,357 @@
  */
 
 #include "spi.h"
-#include "parser.h"
-
-/* Global counters for periodic tasks */
-static uint8_t led_timer_count = 0;    // Counter for LED blinking
-static uint8_t mag_read_count = 0;     // Counter for mag data reading rate
-static uint8_t yaw_rate_count = 0;     // Counter for yaw data transmission
-static uint8_t mag_rate_count = 0;     // Counter for mag data transmission
-volatile uint8_t mag_rate = 5;         // Default magnetometer rate (5Hz)
-
-/* Magnetometer data buffer */
-static MagAvgBuffer mag_buffer = {
-    .x = {0}, 
-    .y = {0},  
-    .z = {0},  
-    .idx = 0   
+#include "telemetry.h"
+#include "command.h"
+#include "filter.h"
+#include "calib.h"
+#include "format.h"
+
+#include "scheduler.h"
+#include "prof.h"
+#include "health.h"
+
+#if UART1_TX_ISR_REPORT
+static uint16_t isr_last_count = 0;    // TX ISR entries at last report
+#endif
+
+/* Command parser, fed by the RX task */
+static parser_state pstate = {
+    .state = STATE_DOLLAR,
+    .index_type = 0,
+    .index_payload = 0,
+    .field_count = 0
+};
+
+/* Periodic tasks (table at the end of the file) */
+enum {
+    TASK_ALGORITHM,
+    TASK_RX,
+    TASK_MAG_CONFIG,
+#if !MAG_SAMPLING_DRDY
+    TASK_MAG_READ,
+#endif
+    TASK_MAG_SAMPLES,
+    TASK_IMU,
+    TASK_MAG_SEND,
+    TASK_YAW_SEND,
+    TASK_LED,
+    TASK_CPU_REPORT,
+#if UART1_TX_ISR_REPORT
+    TASK_ISR_REPORT,
+#endif
+    TASK_COUNT
+};
+static Task tasks[TASK_COUNT];
+
+/* Magnetometer calibration, identity until the first $CAL run */
+static MagCalib mag_calib = {
+    .scale = { CAL_SCALE_ONE, CAL_SCALE_ONE, CAL_SCALE_ONE }
 };
 
+/* Magnetometer smoothing filter */
+static MagFilter mag_filter = {
+    .type = MAG_FILTER_TYPE,
+    .window = MAG_FILTER_WINDOW
+};
+
+/* Latest accelerometer / gyroscope readings, refreshed by task_imu */
+static ImuRaw acc_latest;
+static ImuRaw gyr_latest;
+
 /* Function to simulation 7 ms execution time*/
 void algorithm() {
     tmr_wait_ms(TIMER2, 7);
 }
 
-// Helper Function
-void UART1_SendString(const char *str);
+/* $RATE,n*: set magnetometer output rate (0,1,2,4,5,10 Hz) */
+static CommandResult cmd_rate(const CommandArgs *args) {
+    #define RATE_ENTRY(hz) hz,
+    static const int valid_rates[] = { MAG_VALID_RATES(RATE_ENTRY) };
+    #undef RATE_ENTRY
+    int16_t rate;
+    
+    if (parse_int16(args->field[0], args->len[0], 0, INT16_MAX, &rate) != NUM_OK) {
+        return CMD_ERR_VALUE;
+    }
+    for (uint8_t i = 0; i < sizeof(valid_rates) / sizeof(valid_rates[0]); i++) {
+        if (rate == valid_rates[i]) {
+            // 0 disables the stream, every valid rate divides the frame
+            sched_set_period(&tasks[TASK_MAG_SEND], rate ? SCHED_FRAME_TICKS / rate : 0);
+            return CMD_OK;
+        }
+    }
+    return CMD_ERR_VALUE;
+}
+
+/* $MODE,n*: telemetry format (0 ASCII, 1 binary, 2 binary delta) */
+static CommandResult cmd_mode(const CommandArgs *args) {
+    int16_t mode;
+    
+    if (parse_int16(args->field[0], args->len[0], 0, TLM_MODE_COUNT - 1, &mode) != NUM_OK ||
+        !telemetry_set_mode(mode)) {
+        return CMD_ERR_VALUE;
+    }
+    return CMD_OK;
+}
+
+/* $FILT,type,window*: smoothing filter (0 boxcar, 1 EMA, 2 median), window 1..8 */
+static CommandResult cmd_filt(const CommandArgs *args) {
+    int16_t type, window;
+    
+    if (parse_int16(args->field[0], args->len[0], 0, FILTER_COUNT - 1, &type) != NUM_OK ||
+        parse_int16(args->field[1], args->len[1], 1, FILTER_WINDOW_MAX, &window) != NUM_OK ||
+        !filter_config(&mag_filter, type, window)) {
+        return CMD_ERR_VALUE;
+    }
+    return CMD_OK;
+}
+
+/* New correction: drop filter history built with the old one so outputs do not mix them */
+static void mag_filter_restart(void) {
+    filter_config(&mag_filter, mag_filter.type, mag_filter.window);
+}
+
+/* $CAL,n*: calibration (0 stop and apply, 1 start, 2 read out, 3 reset) */
+static CommandResult cmd_cal(const CommandArgs *args) {
+    int16_t action;
+    
+    if (parse_int16(args->field[0], args->len[0], 0, 3, &action) != NUM_OK) {
+        return CMD_ERR_VALUE;
+    }
+    switch (action) {
+        case 0:
+            if (!calib_stop(&mag_calib)) {
+                return CMD_ERR_VALUE;
+            }
+            mag_filter_restart();
+            return CMD_OK;
+        case 1:
+            calib_start(&mag_calib);   // Correction unchanged until the stop
+            return CMD_OK;
+        case 3:
+            calib_reset(&mag_calib);
+            mag_filter_restart();
+            return CMD_OK;
+        default:
+            break;
+    }
+    
+    // $CAL,running,samples,ox,oy,oz,sx,sy,sz*: offsets in LSB, scales in Q2.14
+    char msg[80];
+    char offset[3][FMT_FIXED2_MAX];
+    for (uint8_t i = 0; i < 3; i++) {
+        fmt_centi(offset[i], (int32_t)mag_calib.offset[i] * 100 / MAG_RAW_SCALE);
+    }
+    snprintf(msg, sizeof(msg), "$CAL,%u,%u,%s,%s,%s,%u,%u,%u*",
+             (unsigned)mag_calib.running, mag_calib.samples,
+             offset[0], offset[1], offset[2],
+             mag_calib.scale[0], mag_calib.scale[1], mag_calib.scale[2]);
+    UART1_SendString(msg);
+    return CMD_OK;
+}
+
+#if PROF_ENABLE
+/* $PRF,n[,1]*: profile of task n (PROF_STAGE_TICK: whole tick), 1 clears it after the reply */
+static CommandResult cmd_prf(const CommandArgs *args) {
+    int16_t stage, clear = 0;
+    char msg[PROF_FRAME_MAX];
+    
+    if (parse_int16(args->field[0], args->len[0], 0, PROF_STAGES - 1, &stage) != NUM_OK ||
+        (stage >= TASK_COUNT && stage != PROF_STAGE_TICK)) {
+        return CMD_ERR_VALUE;
+    }
+    if (args->count > 1 && parse_int16(args->field[1], args->len[1], 0, 1, &clear) != NUM_OK) {
+        return CMD_ERR_VALUE;
+    }
+    if (!prof_format(stage, msg, sizeof(msg))) {
+        return CMD_ERR_VALUE;
+    }
+    UART1_SendString(msg);
+    if (clear) {
+        prof_reset(stage);
+    }
+    return CMD_OK;
+}
+#endif
+
+/* $STAT*: loop timing, ring overflows and error counters in one frame */
+static CommandResult cmd_stat(const CommandArgs *args) {
+    char msg[STAT_FRAME_MAX];
+    
+    if (!health_format(&pstate, msg, sizeof(msg))) {
+        return CMD_ERR_VALUE;
+    }
+    UART1_SendString(msg);
+    return CMD_OK;
+}
+
+/* $IMU*: latest raw accelerometer and gyroscope axes */
+static CommandResult cmd_imu(const CommandArgs *args) {
+    char msg[48];
+    
+    snprintf(msg, sizeof(msg), "$IMU,%d,%d,%d,%d,%d,%d*",
+             acc_latest.x, acc_latest.y, acc_latest.z,
+             gyr_latest.x, gyr_latest.y, gyr_latest.z);
+    UART1_SendString(msg);
+    return CMD_OK;
+}
+
+/* Command registry */
+static const CommandEntry commands[] = {
+    { CMD_KEY('R','A','T','E',0), 1, cmd_rate },
+    { CMD_KEY('M','O','D','E',0), 1, cmd_mode },
+    { CMD_KEY('F','I','L','T',0), 2, cmd_filt },
+    { CMD_KEY('C','A','L',0,0),   1, cmd_cal },
+    { CMD_KEY('S','T','A','T',0), 0, cmd_stat },
+    { CMD_KEY('I','M','U',0,0),   0, cmd_imu },
+#if PROF_ENABLE
+    { CMD_KEY('P','R','F',0,0),   1, cmd_prf },
+#endif
+};
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+/* Called by parse_bytes for every complete message */
+static void on_message(parser_state* ps, int result, void* ctx) {
+    if (result == NEW_MESSAGE) {
+        command_dispatch(commands, COMMAND_COUNT, ps);
+    }
+}
+
+/* RX: parse everything received since the last run */
+static void task_rx(void) {
+    UART_Span span[2];
+    uint8_t count;
+    bool rx_idle = true;
+    
+    // RX ring is SPSC: parse in place, the ISR keeps filling behind us
+    while ((count = UART1_RxBuffer_Peek(&uart1_rx, span)) > 0) {
+        rx_idle = false;
+        for (uint8_t i = 0; i < count; i++) {
+            parse_bytes(&pstate, span[i].ptr, span[i].len, on_message, NULL);
+            UART1_RxBuffer_Consume(&uart1_rx, span[i].len);
+        }
+    }
+    // A quiet tick means no checksum is coming for a message ending in '*'
+    if (rx_idle && parse_flush(&pstate) == NEW_MESSAGE) {
+        command_dispatch(commands, COMMAND_COUNT, &pstate);
+    }
+}
+
+/* Apply pending magnetometer configuration once its settle time has passed */
+static void task_mag_config(void) {
+    mag_config_flush();
+}
+
+#if !MAG_SAMPLING_DRDY
+/* Start a magnetometer burst, the SPI interrupt clocks it */
+static void task_mag_read(void) {
+    mag_read_start();
+}
+#endif
+
+/* Process every new sample exactly once (DRDY or polled) */
+static void task_mag_samples(void) {
+    MagSample sample;
+    
+    while (mag_sample_pop(&sample)) {
+        calib_update(&mag_calib, sample.raw);   // Widen envelope while calibrating
+        filter_update(&mag_filter, calib_apply(&mag_calib, sample.raw));  // Corrected sample into the filter
+    }
+}
+
+/* Collect the last accelerometer / gyroscope reads and queue the next ones behind the magnetometer */
+static void task_imu(void) {
+    acc_read(&acc_latest);   // Unchanged while a read is still pending
+    gyr_read(&gyr_latest);
+    acc_read_start();
+    gyr_read_start();
+}
+
+/* Send Magnetometer Data at the $RATE setting */
+static void task_mag_send(void) {
+    MagData avg = filter_output(&mag_filter);  // Get filtered data
+    send_mag_data(&avg);                       // Transmit via UART
+}
+
+/* Send YAW angles at 5Hz */
+static void task_yaw_send(void) {
+    MagData avg = filter_output(&mag_filter);  // Cached if already read
+    int16_t yaw = compute_yaw_angle(&avg);     // Calculate yaw angle (centi-degrees)
+    send_yaw_data(yaw);                        // Transmit via UART
+}
+
+/* Blink LED2 with 1Hz frequency */
+static void task_led(void) {
+    LED2 ^= 1;
+}
+
+/* Report CPU and SPI bus load once per second (permille) */
+static void task_cpu_report(void) {
+    char msg[24];
+    
+    snprintf(msg, sizeof(msg), "$CPU,%u,%u*",
+             1000 - tmr_idle_permille(), spibus_load_permille());
+    UART1_SendText(&report_stream, msg);   // Never stalls the tick
+}
+
+#if UART1_TX_ISR_REPORT
+/* Report TX ISR entries per second (DMA vs byte-wise path) */
+static void task_isr_report(void) {
+    uint16_t isr_count = uart1_tx.isr_count;
+    char msg[16];
+    
+    snprintf(msg, sizeof(msg), "$ISR,%u*", isr_count - isr_last_count);
+    isr_last_count = isr_count;
+    UART1_SendText(&report_stream, msg);
+}
+#endif
+
+/* Periodic task table: period (ticks), priority (0 first), budget (us) */
+STATIC_ASSERT(SCHED_FRAME_TICKS % LED_BLINK_TICKS == 0, led_period);
+STATIC_ASSERT(SCHED_FRAME_TICKS % DATA_READ_TICKS == 0, read_period);
+STATIC_ASSERT(SCHED_FRAME_TICKS % IMU_READ_TICKS == 0, imu_period);
+STATIC_ASSERT(SCHED_FRAME_TICKS % YAW_SEND_TICKS == 0, yaw_period);
+STATIC_ASSERT(SCHED_FRAME_TICKS % ISR_REPORT_TICKS == 0, report_period);
+STATIC_ASSERT(SCHED_FRAME_TICKS % CPU_REPORT_TICKS == 0, cpu_period);
+
+static Task tasks[TASK_COUNT] = {
+    [TASK_ALGORITHM]   = { .run = algorithm,        .period = 1,                    .priority = 0, .budget_us = 7000 },
+    [TASK_RX]          = { .run = task_rx,          .period = 1,                    .priority = 0, .budget_us = 300 },
+    [TASK_MAG_CONFIG]  = { .run = task_mag_config,  .period = 1,                    .priority = 2, .budget_us = 50 },
+#if !MAG_SAMPLING_DRDY
+    [TASK_MAG_READ]    = { .run = task_mag_read,    .period = DATA_READ_TICKS,      .priority = 1, .budget_us = 50 },
+#endif
+    [TASK_MAG_SAMPLES] = { .run = task_mag_samples, .period = 1,                    .priority = 1, .budget_us = 200 },
+    [TASK_IMU]         = { .run = task_imu,         .period = IMU_READ_TICKS,       .priority = 1, .budget_us = 50 },
+    [TASK_MAG_SEND]    = { .run = task_mag_send,    .period = SCHED_FRAME_TICKS / 5, .priority = 2, .budget_us = 400 },  // 5Hz default
+    [TASK_YAW_SEND]    = { .run = task_yaw_send,    .period = YAW_SEND_TICKS,       .priority = 2, .budget_us = 300 },
+    [TASK_LED]         = { .run = task_led,         .period = LED_BLINK_TICKS,      .priority = 3, .budget_us = 20 },
+    [TASK_CPU_REPORT]  = { .run = task_cpu_report,  .period = CPU_REPORT_TICKS,     .priority = 3, .budget_us = 200 },
+#if UART1_TX_ISR_REPORT
+    [TASK_ISR_REPORT]  = { .run = task_isr_report,  .period = ISR_REPORT_TICKS,     .priority = 3, .budget_us = 200 },
+#endif
+};
 
 int main(void) {
     
-    // Initialize all required configurations
-    config_init();  // GPIO, UART, SPI, Timers, Magnetometer
+    // Initialize all required configurations (GPIO, UART, SPI, Timers, Magnetometer).
+    // Without a link LED1 stays on as the fault indicator instead of flagging misses
+    bool link_ok = config_init();
+    LED1 = !link_ok;
     
-    // parser initialization
-    parser_state pstate = {
-        .state = STATE_DOLLAR,
-        .index_type = 0,
-        .index_payload = 0
-    };
+    // Spread the periodic tasks over the ticks
+    sched_init(tasks, TASK_COUNT);
     
-    // Set up 10ms periodic timer
-    tmr_setup_period(TIMER1, TIMER1_PERIOD_MS);
+    // Set up 10ms periodic tick interrupt
+    tmr_tick_start(TIMER1_PERIOD_MS);
     
     while(1) {
-        algorithm();
-        
-        /* Code to handle the assignment */
-       
-        /* Blink LED2 with 1Hz frequency */
-        led_timer_count++;
-        if (led_timer_count >= LED_BLINK_TICKS) {    // 50*10 ms = 500 ms
-            LED2^= 1;                   // Toggle LED2
-            led_timer_count = 0;        // Reset the counter
-        }
-        
-        /* Process Receive UART messages */
-        uint8_t byte;
+        sched_run(tasks, TASK_COUNT);
         
-        // Disable RX interrupt temporarily
-        IEC0bits.U1RXIE = 0;
-        // Critical section: Read and process
-        while (UART1_RxBuffer_Read(&uart1_rx, &byte)) {
-            if (parse_byte(&pstate, byte) == NEW_MESSAGE) {
-                if (strcmp(pstate.msg_type, "RATE") == 0) {
-                    int rate = extract_integer(pstate.msg_payload);
-                    
-                    // Validate rate (0,1,2,4,5,10 Hz)
-                    const int valid_rates[] = {0,1,2,4,5,10};
-                    bool valid = false;
-                    for (int i = 0; i < 6; i++) {
-                        if (rate == valid_rates[i]) {
-                            valid = true;
-                            break;
-                        }
-                    }
-                    
-                    if (valid) {
-                        mag_rate = rate;
-                    } else {
-                        UART1_SendString("$ERR,1*");
-                    }
-                }
-            }
-        }
-        // Re-enable RX interrupt
-        IEC0bits.U1RXIE = 1;
-        
-        /* Read Magnetometer Data at 25Hz (every 40ms) */
-        mag_read_count++;
-        if (mag_read_count >= DATA_READ_TICKS) {  // 40ms elapsed (4*10ms)
-            mag_read_count = 0;
-            MagData raw_data = read_mag_all();      // Read raw data
-            update_mag_avg(&mag_buffer, raw_data);  // Update moving average
-        }
-        
-        /* Send Magnetometer Data at configured rate */
-        if (mag_rate > 0) {  // Skip if rate is 0 (disabled)
-            mag_rate_count++;
-            uint16_t mag_ticks = 100 / mag_rate;  // Convert Hz to ticks
-            if (mag_rate_count >= mag_ticks) {
-                mag_rate_count = 0;
-                MagData avg = get_avg_mag(&mag_buffer);  // Get averaged data
-                send_mag_data(&avg);                     // Transmit via UART
-            }
-        }
-        
-        /* Send YAW angles at 5Hz (every 200ms) */
-        yaw_rate_count++;
-        if (yaw_rate_count >= YAW_SEND_TICKS) {  // 200ms elapsed (20*10ms)
-            yaw_rate_count = 0;
-            MagData avg = get_avg_mag(&mag_buffer);
-            float yaw = compute_yaw_angle(&avg);  // Calculate yaw angle
-            send_yaw_data(yaw);                   // Transmit via UART
-        }
-        
-        uint8_t ret = tmr_wait_period(TIMER1);
-        if (ret > 0) LED1 ^= 1;  // Toggle LED1 if deadline missed (debug)
+        uint8_t ret = tmr_tick_wait();  // CPU idles until the next tick
+        health_tick(ret);        // Deadline misses and lateness for $STAT
+        if (ret > 0 && link_ok) LED1 ^= 1;  // Toggle LED1 if deadline missed (debug)
     }
     return 0;
 }
-
-/* Helper function to send strings for error */
-void UART1_SendString(const char *str) {
-    IEC0bits.U1TXIE = 0;  // Disable TX interrupt
-    while (*str) {
-        while (UART1_TxBuffer_IsFull(&uart1_tx));  // Wait for buffer space
-        UART1_TxBuffer_Write(&uart1_tx, *str++);   // Send character
-    }
-    IEC0bits.U1TXIE = 1;  // Re-enable interrupt
-    IFS0bits.U1TXIF = 1;  // Trigger transmission
-}
\ No newline at end of file
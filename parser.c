@@ -1,16 +1,60 @@
 #include "parser.h"
+#include "stdbool.h"
+#include "string.h"
+#include "limits.h"
 
 /**
- * Parses incoming bytes to detect NMEA-style messages ($TYPE,PAYLOAD* format)
- * Returns NEW_MESSAGE when a complete message is received, NO_MESSAGE otherwise
+ * Converts an ASCII hex digit to its value
+ * Returns -1 if the byte is not a hex digit
+ */
+static int hex_value(char byte) {
+    if (byte >= '0' && byte <= '9') return byte - '0';
+    if (byte >= 'A' && byte <= 'F') return byte - 'A' + 10;
+    if (byte >= 'a' && byte <= 'f') return byte - 'a' + 10;
+    return -1;
+}
+
+/**
+ * Resets the state for a message whose '$' was just received
+ */
+static void start_message(parser_state* ps) {
+    ps->state = STATE_TYPE;
+    ps->index_type = 0;
+    ps->checksum = 0;
+}
+
+/**
+ * Records the length of the payload field being collected
+ */
+static void close_field(parser_state* ps) {
+    int n = ps->field_count - 1;
+    if (n >= 0 && n < PARSER_MAX_FIELDS) {
+        ps->field_len[n] = ps->index_payload - ps->field_start[n];
+    }
+}
+
+/**
+ * Records the start of a new payload field at the current payload index
+ */
+static void open_field(parser_state* ps) {
+    if (ps->field_count < PARSER_MAX_FIELDS) {
+        ps->field_start[ps->field_count] = ps->index_payload;
+        ps->field_len[ps->field_count] = 0;
+    }
+    ps->field_count++;
+}
+
+/**
+ * Parses incoming bytes to detect NMEA-style messages ($TYPE,PAYLOAD*HH format)
+ * Returns NEW_MESSAGE when a complete message is received, PARSE_ERROR when a
+ * message fails its checksum, NO_MESSAGE otherwise
  */
 int parse_byte(parser_state* ps, char byte) {
     switch (ps->state) {
         case STATE_DOLLAR:
             // Wait for start of message ('$')
             if (byte == '$') {
-                ps->state = STATE_TYPE;
-                ps->index_type = 0;
+                start_message(ps);
             }
             break;
 
@@ -20,71 +64,308 @@ int parse_byte(parser_state* ps, char byte) {
                 ps->state = STATE_PAYLOAD;
                 ps->msg_type[ps->index_type] = '\0';  // Null-terminate type
                 ps->index_payload = 0;
+                ps->field_count = 0;
+                open_field(ps);                       // First field starts here
+                ps->checksum ^= byte;
             } 
-            // Handle malformed message (type too long)
-            else if (ps->index_type == 6) {
-                ps->state = STATE_DOLLAR;
-                ps->index_type = 0;
-            }
             // Handle message without payload ($TYPE*)
             else if (byte == '*') {
-                ps->state = STATE_DOLLAR;
+                ps->state = STATE_CHECKSUM;
                 ps->msg_type[ps->index_type] = '\0';
                 ps->msg_payload[0] = '\0';
-                return NEW_MESSAGE;
+                ps->index_payload = 0;
+                ps->field_count = 0;
+                ps->index_checksum = 0;
             } 
+            // Handle malformed message (type too long, keep room for the terminator)
+            else if (ps->index_type == PARSER_TYPE_SIZE - 1) {
+                ps->state = STATE_DOLLAR;
+                ps->index_type = 0;
+                ps->errors++;
+            }
             // Store valid type character
             else {
                 ps->msg_type[ps->index_type] = byte;
                 ps->index_type++;
+                ps->checksum ^= byte;
             }
             break;
 
         case STATE_PAYLOAD:
-            // End of message detected
+            // End of message detected, checksum may follow
             if (byte == '*') {
-                ps->state = STATE_DOLLAR;
+                ps->state = STATE_CHECKSUM;
                 ps->msg_payload[ps->index_payload] = '\0';  // Null-terminate
-                return NEW_MESSAGE;
+                close_field(ps);
+                ps->index_checksum = 0;
             } 
-            // Handle payload overflow
-            else if (ps->index_payload == 100) {
+            // Handle payload overflow (keep room for the terminator)
+            else if (ps->index_payload == PARSER_PAYLOAD_SIZE - 1) {
                 ps->state = STATE_DOLLAR;
                 ps->index_payload = 0;
+                ps->errors++;
             } 
-            // Store payload byte
+            // Store payload byte, indexing fields as they arrive
             else {
+                if (byte == ',') {
+                    close_field(ps);
+                }
                 ps->msg_payload[ps->index_payload] = byte;
                 ps->index_payload++;
+                ps->checksum ^= byte;
+                if (byte == ',') {
+                    open_field(ps);
+                }
             }
             break;
+
+        case STATE_CHECKSUM: {
+            int digit = hex_value(byte);
+            
+            // Collect the two checksum digits and verify them
+            if (digit >= 0) {
+                ps->checksum_rx = (ps->checksum_rx << 4) | digit;
+                ps->index_checksum++;
+                if (ps->index_checksum == 2) {
+                    ps->state = STATE_DOLLAR;
+                    if (ps->checksum_rx != ps->checksum) {
+                        ps->errors++;
+                        return PARSE_ERROR;
+                    }
+                    return NEW_MESSAGE;
+                }
+                break;
+            }
+            
+            // No checksum: deliver the message and treat the byte as new input
+            int result = (ps->index_checksum == 0) ? NEW_MESSAGE : PARSE_ERROR;
+            if (result == PARSE_ERROR) {
+                ps->errors++;
+            }
+            ps->state = STATE_DOLLAR;
+            if (byte == '$') {
+                start_message(ps);
+            }
+            return result;
+        }
     }
     return NO_MESSAGE;
 }
 
 /**
- * Extracts integer from string
- * Stops at comma or null terminator
+ * Completes a message still waiting for an optional checksum
+ * Call when no more input is pending
+ */
+int parse_flush(parser_state* ps) {
+    if (ps->state != STATE_CHECKSUM) {
+        return NO_MESSAGE;
+    }
+    ps->state = STATE_DOLLAR;
+    if (ps->index_checksum != 0) {
+        ps->errors++;       // Half a checksum is malformed
+        return PARSE_ERROR;
+    }
+    return NEW_MESSAGE;
+}
+
+/**
+ * Parses a block of bytes, reporting completed messages through cb
+ * Bulk paths only cover bytes parse_byte would handle without a state change
  */
-int extract_integer(const char* str) {
-    int i = 0, number = 0, sign = 1;
+int parse_bytes(parser_state* ps, const uint8_t* data, size_t len, parser_callback cb, void* ctx) {
+    const uint8_t* end = data + len;
+    int messages = 0;
     
-    // Handle sign
-    if (str[i] == '-') {
-        sign = -1;
-        i++;
+    while (data < end) {
+        if (ps->state == STATE_DOLLAR) {
+            // Skip everything up to the next '$'
+            const uint8_t* dollar = memchr(data, '$', end - data);
+            if (dollar == NULL) {
+                break;
+            }
+            data = dollar;
+        }
+        else if (ps->state == STATE_PAYLOAD) {
+            // Copy the run of plain payload bytes that still fits
+            const uint8_t* run = data;
+            const uint8_t* limit = data + (PARSER_PAYLOAD_SIZE - 1 - ps->index_payload);
+            unsigned char checksum = ps->checksum;
+            
+            if (limit > end) {
+                limit = end;
+            }
+            while (run < limit && *run != ',' && *run != '*') {
+                checksum ^= *run++;
+            }
+            
+            size_t n = run - data;
+            memcpy(&ps->msg_payload[ps->index_payload], data, n);
+            ps->index_payload += n;
+            ps->checksum = checksum;
+            data = run;
+            if (data == end) {
+                break;
+            }
+        }
+        
+        // Delimiters and the remaining states go through the byte parser
+        int result = parse_byte(ps, (char)*data++);
+        if (result != NO_MESSAGE) {
+            if (result == NEW_MESSAGE) {
+                messages++;
+            }
+            if (cb != NULL) {
+                cb(ps, result, ctx);
+            }
+        }
+    }
+    return messages;
+}
+
+/**
+ * Returns field n of the last message and its length
+ * Uses the offsets recorded by parse_byte, no rescanning
+ */
+const char* parser_field(const parser_state* ps, int n, int* len) {
+    if (n < 0 || n >= ps->field_count || n >= PARSER_MAX_FIELDS) {
+        return NULL;
+    }
+    *len = ps->field_len[n];
+    return &ps->msg_payload[ps->field_start[n]];
+}
+
+/**
+ * Extracts integer from string up to the next comma or null terminator
+ * The whole value must be a number, checked like parse_int32
+ */
+int extract_integer(const char* str, int* out) {
+    int len = 0;
+    int32_t value;
+    
+    while (str[len] != ',' && str[len] != '\0') {
+        len++;
     }
-    else if (str[i] == '+') {
-        i++;  // sign remains 1
+    int status = parse_int32(str, len, INT_MIN, INT_MAX, &value);
+    if (status == NUM_OK) {
+        *out = (int)value;
     }
+    return status;
+}
 
-    // Convert digits to integer
-    while (str[i] != ',' && str[i] != '\0') {
-        number *= 10;
-        number += str[i] - '0';  // ASCII to digit
-        i++;
+/**
+ * Skips an optional sign, returns the index of the first digit
+ */
+static int parse_sign(const char* str, int len, bool* negative) {
+    *negative = false;
+    if (len > 0 && (str[0] == '-' || str[0] == '+')) {
+        *negative = (str[0] == '-');
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * Accumulates the digits str[i..end) into mag
+ * Returns NUM_ERR_RANGE if the magnitude exceeds limit
+ */
+static int parse_digits(const char* str, int i, int end, uint32_t limit, uint32_t* mag) {
+    uint32_t value = 0;
+    
+    for (; i < end; i++) {
+        uint8_t digit = (uint8_t)(str[i] - '0');
+        if (digit > 9) {
+            return NUM_ERR_SYNTAX;
+        }
+        if (value > (limit - digit) / 10) {
+            return NUM_ERR_RANGE;  // value * 10 + digit would exceed limit
+        }
+        value = value * 10 + digit;
+    }
+    *mag = value;
+    return NUM_OK;
+}
+
+/**
+ * Parses a signed decimal integer field, checking syntax and range
+ */
+int parse_int32(const char* str, int len, int32_t min, int32_t max, int32_t* out) {
+    bool negative;
+    uint32_t mag;
+    int i = parse_sign(str, len, &negative);
+    
+    if (i >= len) {
+        return NUM_ERR_EMPTY;
+    }
+    // Magnitude limit is 2^31 for negative numbers, 2^31 - 1 otherwise
+    int status = parse_digits(str, i, len, negative ? 0x80000000UL : 0x7FFFFFFFUL, &mag);
+    if (status != NUM_OK) {
+        return status;
+    }
+    
+    int32_t value = negative ? (int32_t)(0U - mag) : (int32_t)mag;
+    if (value < min || value > max) {
+        return NUM_ERR_RANGE;
+    }
+    *out = value;
+    return NUM_OK;
+}
+
+/**
+ * Parses a signed decimal integer field into an int16
+ */
+int parse_int16(const char* str, int len, int16_t min, int16_t max, int16_t* out) {
+    int32_t value;
+    int status = parse_int32(str, len, min, max, &value);
+    
+    if (status == NUM_OK) {
+        *out = (int16_t)value;
+    }
+    return status;
+}
+
+/**
+ * Parses a decimal field into Q16.16 fixed point
+ * The fraction is converted right to left at 24 bits, then rounded to 16
+ */
+int parse_q16(const char* str, int len, int32_t* out) {
+    bool negative;
+    uint32_t int_part = 0;
+    uint32_t frac = 0;
+    int i = parse_sign(str, len, &negative);
+    int dot = len;
+    
+    // Locate the decimal point
+    for (int j = i; j < len; j++) {
+        if (str[j] == '.') {
+            dot = j;
+            break;
+        }
+    }
+    if (dot == i && dot + 1 >= len) {
+        return NUM_ERR_EMPTY;  // No digits on either side
+    }
+    
+    int status = parse_digits(str, i, dot, 0x8000UL, &int_part);
+    if (status != NUM_OK) {
+        return status;
+    }
+    
+    // frac = (digit + frac) / 10 per digit, from the last one, in 1/2^24 units
+    for (int j = len - 1; j > dot; j--) {
+        uint8_t digit = (uint8_t)(str[j] - '0');
+        if (digit > 9) {
+            return NUM_ERR_SYNTAX;  // Includes a second '.'
+        }
+        frac = (((uint32_t)digit << 24) + frac) / 10;
+    }
+    
+    // Round to 1/2^16, a carry lands in the integer part
+    uint32_t mag = (int_part << 16) + ((frac + 0x80) >> 8);
+    if (mag > (negative ? 0x80000000UL : 0x7FFFFFFFUL)) {
+        return NUM_ERR_RANGE;
     }
-    return sign * number;
+    *out = negative ? (int32_t)(0U - mag) : (int32_t)mag;
+    return NUM_OK;
 }
 
 /**
@@ -1,18 +1,39 @@
 #ifndef PARSER_H
 #define	PARSER_H
 
+#include "stdint.h"
+#include "stddef.h"
+
 #define STATE_DOLLAR  (1) // we discard everything until a dollar is found
 #define STATE_TYPE    (2) // we are reading the type of msg until a comma is found
 #define STATE_PAYLOAD (3) // we read the payload until an asterix is found
+#define STATE_CHECKSUM (4) // we read the optional two hex digit checksum after the asterix
 #define NEW_MESSAGE (1) // new message received and parsed completely
 #define NO_MESSAGE (0) // no new messages
+#define PARSE_ERROR (-1) // message discarded (bad checksum)
+
+#define NUM_OK (0) // number parsed and in range
+#define NUM_ERR_EMPTY (1) // field has no digits
+#define NUM_ERR_SYNTAX (2) // unexpected character in the field
+#define NUM_ERR_RANGE (3) // value does not fit the requested range
+
+#define PARSER_MAX_FIELDS (8) // payload fields indexed while parsing
+#define PARSER_TYPE_SIZE (6) // msg_type storage, including the string terminator
+#define PARSER_PAYLOAD_SIZE (100) // msg_payload storage, including the string terminator
 
 typedef struct { 
 	int state;
-	char msg_type[6]; // type is 5 chars + string terminator
-	char msg_payload[100];  // assume payload cannot be longer than 100 chars
+	char msg_type[PARSER_TYPE_SIZE]; // type is 5 chars + string terminator
+	char msg_payload[PARSER_PAYLOAD_SIZE];  // payload is at most 99 chars + string terminator
 	int index_type;
 	int index_payload;
+	unsigned char checksum; // XOR of the bytes between '$' and '*'
+	unsigned char checksum_rx; // checksum digits received so far
+	int index_checksum; // number of checksum digits received
+	unsigned char field_start[PARSER_MAX_FIELDS]; // offset of each field in msg_payload
+	unsigned char field_len[PARSER_MAX_FIELDS]; // length of each field
+	int field_count; // number of fields in msg_payload
+	unsigned int errors; // messages dropped: type/payload too long, bad or truncated checksum
 } parser_state;
 
 /*
@@ -20,15 +41,58 @@ Requires a pointer to a parser state, and the byte to process.
 returns NEW_MESSAGE if a message has been successfully parsed.
 The result can be found in msg_type and msg_payload.
 Parsing another byte will override the contents of those arrays.
+A type longer than 5 chars or a payload longer than 99 chars discards the message.
 */
 int parse_byte(parser_state* ps, char byte);
 
 /*
-Takes a string as input, and converts it to an integer. Stops parsing when reaching
-the end of string or a ","
-the result is undefined if a wrong string is passed
+A message may end in "*HH", the NMEA checksum (XOR of all bytes between '$' and '*').
+When present it is verified and a mismatch returns PARSE_ERROR. Without it the message
+is delivered on the next byte that is not a hex digit, or by parse_flush() when no more
+input is pending. Returns NEW_MESSAGE if a message was waiting for its checksum.
+*/
+int parse_flush(parser_state* ps);
+
+/*
+Called by parse_bytes for every message that completes (result is NEW_MESSAGE or
+PARSE_ERROR). The message is in ps and is valid only during the call.
+*/
+typedef void (*parser_callback)(parser_state* ps, int result, void* ctx);
+
+/*
+Parses len bytes in one call, with the same results as calling parse_byte on each of
+them. Runs of bytes that cannot change the state (noise before '$', payload between
+delimiters) are skipped or copied in bulk. Returns the number of NEW_MESSAGE results.
+*/
+int parse_bytes(parser_state* ps, const uint8_t* data, size_t len, parser_callback cb, void* ctx);
+
+/*
+Returns a pointer to field n of the last message (not null-terminated) and stores its
+length in len, or returns NULL if the message has fewer fields. Fields are indexed while
+bytes arrive, so this does not rescan the payload.
+*/
+const char* parser_field(const parser_state* ps, int n, int* len);
+
+/*
+Takes a string as input, and converts the value up to the next "," or the end of the
+string to an integer. The value is checked like parse_int32 (range of int), so "12a"
+is NUM_ERR_SYNTAX. Returns NUM_OK and stores the value in out, or the NUM_ERR_* code.
+*/
+int extract_integer(const char* str, int* out);
+
+/*
+Checked parsers for a field span (str, len), e.g. from parser_field(). They never read
+past len and never call the C library. The whole span must be the number: an optional
+sign followed by digits, with a single '.' allowed in parse_q16. On success the value is
+stored in out and NUM_OK is returned, otherwise out is left untouched and the NUM_ERR_*
+code is returned.
+parse_int32/parse_int16 also reject values outside [min, max].
+parse_q16 converts a decimal to Q16.16 (value * 65536, rounded to nearest), range
+-32768.0 to 32767.99998; any number of fraction digits is accepted.
 */
-int extract_integer(const char* str);
+int parse_int32(const char* str, int len, int32_t min, int32_t max, int32_t* out);
+int parse_int16(const char* str, int len, int16_t min, int16_t max, int16_t* out);
+int parse_q16(const char* str, int len, int32_t* out);
 
 /*
 The function takes a string, and an index within the string, and returns the index where the next data can be found
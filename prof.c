@@ -0,0 +1,76 @@
+#include "prof.h"
+#include "uart.h"
+
+#if PROF_ENABLE
+
+// The frame (its terminator is the binary mode delimiter) must fit the TX ring
+STATIC_ASSERT(PROF_FRAME_MAX <= UART_TX_BUF_SIZE, prof_frame_fits);
+STATIC_ASSERT(PROF_STAGES <= 100, prof_stage_digits);
+
+static ProfStage prof_stage[PROF_STAGES];
+
+/* Add one run of a stage */
+void prof_record(uint8_t stage, uint32_t cycles) {
+    ProfStage *p;
+    uint32_t v = cycles >> PROF_BIN_SHIFT;
+    uint8_t bin = 0;
+
+    if (stage >= PROF_STAGES) {
+        return;
+    }
+    p = &prof_stage[stage];
+
+    if (p->count == 0 || cycles < p->min) p->min = cycles;
+    if (cycles > p->max) p->max = cycles;
+    p->sum += cycles;
+    p->count++;
+
+    // floor(log2) above the first bin, clipped to the last one
+    while (v != 0 && bin < PROF_BINS - 1) {
+        v >>= 1;
+        bin++;
+    }
+    if (p->hist[bin] != UINT16_MAX) {
+        p->hist[bin]++;
+    }
+}
+
+/* Clear one stage */
+void prof_reset(uint8_t stage) {
+    if (stage < PROF_STAGES) {
+        memset(&prof_stage[stage], 0, sizeof(prof_stage[stage]));
+    }
+}
+
+/* Cycles to us, clamped so every time field has at most 5 digits */
+static unsigned long prof_us(uint32_t cycles) {
+    uint32_t us = cycles / TMR_CYCLES_PER_US;
+    return (us > PROF_US_MAX) ? PROF_US_MAX : us;
+}
+
+/* Build $PRF,stage,count,min,avg,max,h0,...,h13* with times in us */
+bool prof_format(uint8_t stage, char *out, uint16_t size) {
+    const ProfStage *p;
+    uint32_t avg;
+    int len;
+
+    if (stage >= PROF_STAGES) {
+        return false;
+    }
+    p = &prof_stage[stage];
+    avg = p->count ? (uint32_t)(p->sum / p->count) : 0;
+
+    len = snprintf(out, size, "$PRF,%u,%lu,%lu,%lu,%lu", stage, (unsigned long)p->count,
+                   prof_us(p->min), prof_us(avg), prof_us(p->max));
+    for (uint8_t i = 0; i < PROF_BINS && len > 0 && len < size; i++) {
+        len += snprintf(out + len, size - len, ",%u", p->hist[i]);
+    }
+    if (len <= 0 || len + 1 >= size) {
+        return false;
+    }
+    out[len++] = '*';
+    out[len] = '\0';
+    return true;
+}
+
+#endif
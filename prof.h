@@ -0,0 +1,62 @@
+/*
+ * File:   prof.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 10:05 PM
+ */
+
+#ifndef PROF_H
+#define	PROF_H
+
+#include "timer.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Profiling: 1 = record every task run, 0 = compiled out (no code, no RAM)
+#ifndef PROF_ENABLE
+#define PROF_ENABLE 1
+#endif
+
+// Stages: one per scheduler task slot, the last one times the whole tick
+#define PROF_STAGES      17
+#define PROF_STAGE_TICK  (PROF_STAGES - 1)
+
+// Log2 histogram: bin 0 < 2^PROF_BIN_SHIFT cycles, bin k < 2^(k + PROF_BIN_SHIFT), last bin open
+#define PROF_BINS        14
+#define PROF_BIN_SHIFT   8
+
+// $PRF,stage,count,min,avg,max,h0..h13*: times in us, clamped to PROF_US_MAX
+// worst case: "$PRF," + 2 + 11 + 3 * 6 + PROF_BINS * 6 + "*" + terminator = 122
+#define PROF_US_MAX      65535
+#define PROF_FRAME_MAX   (5 + 2 + 11 + 3 * 6 + PROF_BINS * 6 + 1 + 1)
+
+/*
+ * Execution profile of one stage, durations in cycles from tmr_cycles().
+ * Recording is a compare, an add and a short shift loop for the bin.
+ */
+typedef struct {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;                   // For the average
+    uint16_t hist[PROF_BINS];       // Saturating counts
+} ProfStage;
+
+#if PROF_ENABLE
+#define PROF_RECORD(stage, cycles) prof_record((stage), (cycles))
+#else
+#define PROF_RECORD(stage, cycles) ((void)0)
+#endif
+
+/* Profiler Functions */
+void prof_record(uint8_t stage, uint32_t cycles);            // Use PROF_RECORD
+bool prof_format(uint8_t stage, char *out, uint16_t size);   // $PRF frame, false for an unknown stage
+void prof_reset(uint8_t stage);                              // Clear one stage
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROF_H */
@@ -0,0 +1,135 @@
+#include "scheduler.h"
+#include "prof.h"
+
+STATIC_ASSERT(SCHED_MAX_TASKS <= PROF_STAGE_TICK, prof_stage_per_task);
+
+static uint8_t sched_order[SCHED_MAX_TASKS];   // Task indices by priority
+static uint16_t sched_tick = 0;                // Position in the frame
+static bool sched_replan = false;              // A period changed
+
+/* Release phase (in ticks) for every task, spreading budget over the frame */
+static void sched_plan(Task *tasks, uint8_t count) {
+    static uint16_t load[SCHED_FRAME_TICKS];   // Budget placed on each tick of the frame (us)
+    bool placed[SCHED_MAX_TASKS] = { false };
+    uint8_t n, i;
+
+    memset(load, 0, sizeof(load));
+    for (n = 0; n < count; n++) {
+        // Largest budget first, the small ones fill the gaps
+        uint8_t pick = SCHED_MAX_TASKS;
+        for (i = 0; i < count; i++) {
+            if (!placed[i] && (pick == SCHED_MAX_TASKS || tasks[i].budget_us > tasks[pick].budget_us)) {
+                pick = i;
+            }
+        }
+        placed[pick] = true;
+
+        Task *t = &tasks[pick];
+        if (t->period == 0) {
+            continue;
+        }
+
+        // Phase whose busiest tick is lightest, ties go to the lighter total
+        uint16_t best_phase = 0;
+        uint32_t best_peak = UINT32_MAX, best_sum = UINT32_MAX;
+        for (uint16_t phase = 0; phase < t->period; phase++) {
+            uint32_t peak = 0, sum = 0;
+            for (uint16_t tick = phase; tick < SCHED_FRAME_TICKS; tick += t->period) {
+                if (load[tick] > peak) peak = load[tick];
+                sum += load[tick];
+            }
+            if (peak < best_peak || (peak == best_peak && sum < best_sum)) {
+                best_peak = peak;
+                best_sum = sum;
+                best_phase = phase;
+            }
+        }
+
+        t->phase = best_phase;
+        for (uint16_t tick = best_phase; tick < SCHED_FRAME_TICKS; tick += t->period) {
+            load[tick] += t->budget_us;
+        }
+    }
+}
+
+/* Order the table by priority (stable) and assign phases */
+void sched_init(Task *tasks, uint8_t count) {
+    uint8_t i, j;
+
+    if (count > SCHED_MAX_TASKS) {
+        count = SCHED_MAX_TASKS;
+    }
+    // Insertion sort of the indices, equal priorities keep table order
+    for (i = 0; i < count; i++) {
+        for (j = i; j > 0 && tasks[sched_order[j - 1]].priority > tasks[i].priority; j--) {
+            sched_order[j] = sched_order[j - 1];
+        }
+        sched_order[j] = i;
+    }
+    sched_plan(tasks, count);
+    sched_tick = 0;
+    sched_replan = false;
+}
+
+/* Change a period, the phases are re-planned at the start of the next tick */
+bool sched_set_period(Task *task, uint16_t period) {
+    if (period > SCHED_FRAME_TICKS || (period != 0 && SCHED_FRAME_TICKS % period != 0)) {
+        return false;
+    }
+    if (task->period != period) {
+        task->period = period;
+        task->due = false;
+        sched_replan = true;
+    }
+    return true;
+}
+
+/* Release the tasks due on this tick and run them in priority order */
+void sched_run(Task *tasks, uint8_t count) {
+    const uint32_t budget = (uint32_t)SCHED_TICK_BUDGET_US * TMR_CYCLES_PER_US;
+    uint32_t start = tmr_cycles();
+    uint8_t i;
+
+    if (count > SCHED_MAX_TASKS) {
+        count = SCHED_MAX_TASKS;
+    }
+    if (sched_replan) {
+        sched_replan = false;
+        sched_plan(tasks, count);
+    }
+
+    for (i = 0; i < count; i++) {
+        Task *t = &tasks[i];
+        if (t->period != 0 && sched_tick % t->period == t->phase) {
+            t->due = true;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        Task *t = &tasks[sched_order[i]];
+        if (!t->due) {
+            continue;
+        }
+
+        uint32_t begin = tmr_cycles();
+        uint32_t need = (uint32_t)t->budget_us * TMR_CYCLES_PER_US;
+        if (t->priority > 0 && (begin - start) + need > budget) {
+            t->deferred++;   // No room left in this tick, try again on the next
+            continue;
+        }
+
+        t->due = false;
+        t->run();
+
+        uint32_t cycles = tmr_cycles() - begin;
+        t->runs++;
+        if (cycles > t->max_cycles) t->max_cycles = cycles;
+        if (cycles > need) t->overruns++;
+        PROF_RECORD(sched_order[i], cycles);
+    }
+    PROF_RECORD(PROF_STAGE_TICK, tmr_cycles() - start);
+
+    if (++sched_tick >= SCHED_FRAME_TICKS) {
+        sched_tick = 0;
+    }
+}
@@ -0,0 +1,60 @@
+/*
+ * File:   scheduler.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 9:20 PM
+ */
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#include "timer.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Task periods must divide the frame so phases repeat every second
+#define SCHED_FRAME_TICKS    (1000 / TIMER1_PERIOD_MS)
+#define SCHED_TICK_BUDGET_US (TIMER1_PERIOD_MS * 1000U)
+#define SCHED_MAX_TASKS      16
+
+/*
+ * Cooperative periodic tasks
+ *
+ * A task runs on the ticks where tick % period == phase, so tasks sharing
+ * a period no longer all fire on the same tick. sched_init() assigns the
+ * phases: tasks are placed largest budget first, each at the phase whose
+ * busiest tick (over one frame) carries the least budget so far.
+ *
+ * Due tasks run in priority order (0 first). Priority 0 always runs; any
+ * other task whose budget no longer fits in what is left of the tick
+ * stays due and runs on a later tick instead of stretching this one.
+ * A run longer than its budget counts as an overrun.
+ */
+typedef void (*TaskFunc)(void);
+
+typedef struct {
+    TaskFunc run;
+    uint16_t period;        // Ticks, must divide SCHED_FRAME_TICKS, 0 = disabled
+    uint8_t priority;       // 0 = highest, never deferred
+    uint16_t budget_us;     // Expected worst-case run time
+    // Filled in by the scheduler
+    uint16_t phase;         // Tick offset within the period
+    bool due;               // Released, waiting for room in a tick
+    uint16_t runs;
+    uint16_t deferred;      // Ticks spent waiting for room
+    uint16_t overruns;      // Runs longer than budget_us
+    uint32_t max_cycles;    // Longest run
+} Task;
+
+/* Scheduler Functions */
+void sched_init(Task *tasks, uint8_t count);      // Order by priority and assign phases
+void sched_run(Task *tasks, uint8_t count);       // Run one tick's due tasks
+bool sched_set_period(Task *task, uint16_t period);  // New period (phases re-planned next tick), false if invalid
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SCHEDULER_H */
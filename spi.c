@@ -1,6 +1,27 @@
-
 #include "SPI.h"
 
+/* SPI1BUF access, the host tests route it through their SPI simulator */
+#ifndef SPI1_PUT
+#define SPI1_PUT(b) (SPI1BUF = (b))
+#define SPI1_GET()  ((uint8_t)SPI1BUF)
+#endif
+
+/* SPI1 devices: BMX055 magnetometer, accelerometer and gyroscope dies */
+const SpiDevice mag_device = { &MAG_CS_LAT, MAG_CS_MASK, IMU_SPI_MODE, IMU_SPI_PPRE, IMU_SPI_SPRE };
+const SpiDevice acc_device = { &ACC_CS_LAT, ACC_CS_MASK, IMU_SPI_MODE, IMU_SPI_PPRE, IMU_SPI_SPRE };
+const SpiDevice gyr_device = { &GYR_CS_LAT, GYR_CS_MASK, IMU_SPI_MODE, IMU_SPI_PPRE, IMU_SPI_SPRE };
+
+/* Asynchronous transfer, owned by _SPI1Interrupt while busy */
+static volatile struct {
+    bool busy;
+    const uint8_t *tx;            // NULL: send 0x00
+    uint8_t *rx;                  // NULL: discard
+    uint16_t len;
+    uint16_t sent;                // Bytes written to the TX FIFO
+    uint16_t recv;                // Bytes read from the RX FIFO
+    SpiDoneCallback done;
+} spi_async;
+
 /* Initialize SPI module in master mode with 4.5MHz clock */
 void spi_init() {
     // Configure SPI control registers
@@ -12,156 +33,511 @@ void spi_init() {
     // Set clock prescalers for 4.5MHz
     SPI1CON1bits.PPRE = 1;    // Primary prescaler 4:1
     SPI1CON1bits.SPRE = 4;    // Secondary prescaler 4:1
+    
+    // Enhanced buffer: 8-deep TX/RX FIFOs, interrupt once the FIFO has drained
+    SPI1CON2bits.SPIBEN = 1;
+    SPI1STATbits.SISEL = 0b101;  // Last bit shifted out, TX FIFO empty
 
     SPI1STATbits.SPIEN = 1;   // Enable SPI module
     
-    // Configure magnetometer chip select pin
-    TRISDbits.TRISD6 = 0;     // Set CS pin as output
+    // Configure chip select pins, every die on the bus deselected
+    TRISDbits.TRISD6 = 0;     // Set CS pins as outputs
+    ACC_CS_TRIS = 0;
+    GYR_CS_TRIS = 0;
     MAG_CS = 1;               // Deselect magnetometer initially
+    ACC_CS_LAT |= ACC_CS_MASK;
+    GYR_CS_LAT |= GYR_CS_MASK;
+}
+
+/* Fill the TX FIFO without letting more than SPI_FIFO_DEPTH bytes be in flight */
+static uint16_t spi_fill(const uint8_t *tx, uint16_t sent, uint16_t recv, uint16_t len) {
+    while (sent < len && sent - recv < SPI_FIFO_DEPTH && !SPI1STATbits.SPITBF) {
+        SPI1_PUT((tx != NULL) ? tx[sent] : 0x00);
+        sent++;
+    }
+    return sent;
+}
+
+/* Read everything the RX FIFO holds */
+static uint16_t spi_drain(uint8_t *rx, uint16_t recv) {
+    while (!SPI1STATbits.SRXMPT) {
+        uint8_t byte = SPI1_GET();
+        if (rx != NULL) {
+            rx[recv] = byte;
+        }
+        recv++;
+    }
+    return recv;
+}
+
+/* Full-duplex burst with the FIFO kept full (blocking) */
+void spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len) {
+    uint16_t sent = 0, recv = 0;
+    
+    while (recv < len) {
+        sent = spi_fill(tx, sent, recv, len);
+        recv = spi_drain(rx, recv);
+    }
 }
 
-/* Write 16-bit data to SPI and return received data */
+/* Write one byte and return the byte received */
 uint16_t spi_write(uint16_t data) {
-    // Wait for transmit buffer to be empty
-    while (SPI1STATbits.SPITBF);
+    uint8_t tx = (uint8_t)data;
+    uint8_t rx;
+    
+    spi_transfer(&tx, &rx, 1);
+    return rx;
+}
+
+/* Start a burst clocked by _SPI1Interrupt, done runs in the interrupt */
+bool spi_transfer_start(const uint8_t *tx, uint8_t *rx, uint16_t len, SpiDoneCallback done) {
+    if (spi_async.busy || len == 0) {
+        return false;
+    }
+    spi_async.busy = true;
+    spi_async.tx = tx;
+    spi_async.rx = rx;
+    spi_async.len = len;
+    spi_async.recv = 0;
+    spi_async.done = done;
+    
+    // Nothing may be left from a blocking transfer
+    spi_drain(NULL, 0);
+    SPI1STATbits.SPIROV = 0;
+    
+    spi_async.sent = spi_fill(tx, 0, 0, len);
+    IFS0bits.SPI1IF = 0;
+    IEC0bits.SPI1IE = 1;
+    return true;
+}
+
+/* True while an asynchronous burst is in progress */
+bool spi_busy(void) {
+    return spi_async.busy;
+}
+
+/* SPI1 interrupt: FIFO drained, collect it and queue the next chunk */
+void __attribute__((interrupt, no_auto_psv)) _SPI1Interrupt(void) {
+    IFS0bits.SPI1IF = 0;  // Clear the interrupt flag
+    
+    spi_async.recv = spi_drain(spi_async.rx, spi_async.recv);
+    if (spi_async.recv < spi_async.len) {
+        spi_async.sent = spi_fill(spi_async.tx, spi_async.sent, spi_async.recv, spi_async.len);
+        return;
+    }
+    
+    IEC0bits.SPI1IE = 0;  // Blocking transfers own the bus again
+    spi_async.busy = false;
+    if (spi_async.done != NULL) {
+        spi_async.done();
+    }
+}
+
+/* Read len consecutive registers of a device starting at reg (blocking) */
+static void imu_read_regs(const SpiDevice *dev, uint8_t reg, uint8_t *data, uint8_t len) {
+    uint8_t tx = reg | 0x80;  // Read command (MSB=1)
+    
+    spibus_select(dev);
+    spi_transfer(&tx, NULL, 1);       // Address, echo discarded
+    spi_transfer(NULL, data, len);    // Register values, FIFO kept full
+    spibus_deselect(dev);
+}
+
+/* Magnetometer configuration cache (MAG_SHADOW_FIRST..MAG_REP_Z) */
+static void mag_config_done(SpiTransaction *t);
+static struct {
+    uint8_t value[MAG_SHADOW_COUNT];  // Last value written or requested
+    uint8_t known;                    // Bit per register: value matches the sensor
+    uint8_t dirty;                    // Bit per register: value waits for a flush
+    uint8_t id;                       // Last chip ID read, 0 before
+    uint8_t id_retries;               // Mismatches left before giving up
+    bool id_read;                     // ID read since the last power control write
+    bool id_ok;
+    volatile bool settling;           // ready_at is valid
+    volatile uint32_t ready_at;       // Settle deadline (tmr_cycles)
+    uint16_t settle_us;               // Settle time of the burst in flight
+    uint8_t tx[2 * MAG_SHADOW_COUNT]; // Address/value pairs, or the ID read
+    uint8_t rx[3];
+    SpiTransaction txn;
+} mag_cfg = {
+    .known = 1U << (MAG_POWER_CTRL - MAG_SHADOW_FIRST),  // Power control is 0x00 after reset
+    .id_retries = MAG_ID_RETRIES,
+    .txn = { .dev = &mag_device, .priority = SPIBUS_PRIO_NORMAL, .done = mag_config_done }
+};
+
+/* Burst written (SPI interrupt): start the settle time */
+static void mag_config_done(SpiTransaction *t) {
+    if (mag_cfg.settle_us != 0) {
+        mag_cfg.ready_at = tmr_deadline_us(mag_cfg.settle_us);
+        mag_cfg.settling = true;
+    }
+}
+
+/* Update a shadowed register, a value the sensor already holds is not written again */
+bool mag_reg_write(uint8_t reg, uint8_t value) {
+    uint8_t index = reg - MAG_SHADOW_FIRST;
+    uint8_t bit;
+    
+    if (reg < MAG_SHADOW_FIRST || index >= MAG_SHADOW_COUNT) {
+        return false;
+    }
+    bit = 1U << index;
+    if ((mag_cfg.known & bit) && mag_cfg.value[index] == value) {
+        mag_cfg.dirty &= ~bit;  // Cancel a pending change back to the current value
+        return true;
+    }
+    mag_cfg.value[index] = value;
+    mag_cfg.dirty |= bit;
+    return true;
+}
+
+/* Settle deadline passed and no configuration burst queued */
+bool mag_config_ready(void) {
+    if (mag_cfg.txn.pending) {
+        return false;
+    }
+    if (mag_cfg.settling && !tmr_expired(mag_cfg.ready_at)) {
+        return false;
+    }
+    mag_cfg.settling = false;  // Deadline passed, forget it before the counter wraps
+    return true;
+}
+
+/* Queue the next configuration step, true once nothing is left to do */
+bool mag_config_flush(void) {
+    const uint8_t power_bit = 1U << (MAG_POWER_CTRL - MAG_SHADOW_FIRST);  // value[0]
+    uint8_t len = 0;
+    uint8_t i;
+    
+    if (!mag_config_ready()) {
+        return false;
+    }
     
-    SPI1BUF = data;           // Send data
+    // Result of the previous ID read
+    if (mag_cfg.txn.rx != NULL) {
+        mag_cfg.txn.rx = NULL;
+        mag_cfg.id = mag_cfg.rx[2];
+        mag_cfg.id_read = true;
+        mag_cfg.id_ok = (mag_cfg.id == MAG_CHIP_ID_VALUE);
+        if (!mag_cfg.id_ok && mag_cfg.id_retries > 0) {
+            mag_cfg.id_retries--;
+            mag_cfg.dirty |= mag_cfg.known;  // Sensor reset: rewrite the whole cache
+            mag_cfg.known = 0;
+        }
+    }
     
-    // Wait for receive buffer to have data
-    while (!SPI1STATbits.SPIRBF);
+    if (mag_cfg.dirty & power_bit) {
+        // Other registers only respond once out of suspend: power control goes alone
+        mag_cfg.tx[len++] = MAG_POWER_CTRL;
+        mag_cfg.tx[len++] = mag_cfg.value[0];
+        mag_cfg.known |= power_bit;
+        mag_cfg.dirty &= ~power_bit;
+        mag_cfg.settle_us = MAG_SETTLE_POWER_US;
+        mag_cfg.id_read = false;
+        mag_cfg.id_ok = false;
+    } else if (!(mag_cfg.value[0] & 0x01)) {
+        return mag_cfg.dirty == 0;  // Suspended: nothing else can be written
+    } else if (!mag_cfg.id_read) {
+        // Powered and settled: check the chip ID (the first byte after the address is a dummy)
+        mag_cfg.tx[0] = MAG_CHIP_ID | 0x80;
+        mag_cfg.tx[1] = 0x00;
+        mag_cfg.tx[2] = 0x00;
+        mag_cfg.txn.rx = mag_cfg.rx;
+        len = sizeof(mag_cfg.rx);
+        mag_cfg.settle_us = 0;
+    } else {
+        // Every dirty register as address/value pairs under one CS
+        for (i = 1; i < MAG_SHADOW_COUNT; i++) {
+            if (mag_cfg.dirty & (1U << i)) {
+                mag_cfg.tx[len++] = MAG_SHADOW_FIRST + i;
+                mag_cfg.tx[len++] = mag_cfg.value[i];
+            }
+        }
+        mag_cfg.known |= mag_cfg.dirty;
+        mag_cfg.dirty = 0;
+        mag_cfg.settle_us = 0;
+        if (len == 0) {
+            return mag_cfg.id_ok;
+        }
+    }
     
-    return SPI1BUF;           // Return received data
+    mag_cfg.txn.tx = mag_cfg.tx;
+    mag_cfg.txn.len = len;
+    spibus_submit(&mag_cfg.txn);
+    return false;
+}
+
+/* Chip ID matched after power-up */
+bool mag_chip_ok(void) {
+    return mag_cfg.id_ok;
+}
+
+/* Chip ID check result, FAILED once every retry read a wrong ID */
+MagChipState mag_chip_state(void) {
+    if (mag_cfg.id_ok) {
+        return MAG_CHIP_OK;
+    }
+    if (mag_cfg.id_read && mag_cfg.id_retries == 0) {
+        return MAG_CHIP_FAILED;
+    }
+    return MAG_CHIP_PENDING;
 }
 
 /* Put magnetometer into low-power sleep mode */
 void mag_sleep(void) {
-    MAG_CS = 0;                          // Select magnetometer
-    spi_write(MAG_POWER_CTRL);           // Address power control register
-    spi_write(0x01);                     // Set sleep mode bit
-    MAG_CS = 1;                         // Deselect magnetometer
-    tmr_wait_ms(TIMER1, 3);             // Wait 3ms for command to complete
+    mag_reg_write(MAG_POWER_CTRL, 0x01);  // Set power control bit (suspend -> sleep)
 }
 
 /* Wake magnetometer and set to active measurement mode */
 void mag_active(void) {
-    MAG_CS = 0;                          // Select magnetometer
-    spi_write(MAG_CTRL_REG2);            // Address control register 2
-    spi_write((0b110 << 3) | 0b00);      // Set 25Hz data rate
-    MAG_CS = 1;                         // Deselect magnetometer
-    tmr_wait_ms(TIMER1, 3);             // Wait 3ms for command to complete
+    mag_reg_write(MAG_CTRL_REG2, (0b110 << 3) | 0b00);  // Set 25Hz data rate, normal mode
 }
 
-/* Read magnetometer's chip identification register */
+/* Chip ID read by mag_config_flush() */
 uint8_t read_chip_id(void) {
-    uint8_t id;
-    
-    MAG_CS = 0;                          // Select magnetometer
-    spi_write(MAG_CHIP_ID | 0x80);       // Read command (MSB=1)
-    spi_write(0x00);                     // Dummy write
-    id = spi_write(0x00);                // Read actual ID
-    MAG_CS = 1;                         // Deselect magnetometer
-    
-    return id;                           // Return chip ID
+    return mag_cfg.id;
 }
 
-/* Read raw magnetometer data for all axes */
-MagData read_mag_all(void) {
-    MagData data;
-    uint8_t lsb_x, msb_x, lsb_y, msb_y, lsb_z, msb_z;
-
-    MAG_CS = 0;                          // Select magnetometer
-    spi_write(MAG_DATA_X_LSB | 0x80);    // Start read from X_LSB register
+/* Decode the six data registers (LSB/MSB pairs for X, Y, Z) */
+static MagRaw mag_decode(const uint8_t *reg) {
+    MagRaw data;
     
-    // Read all 6 bytes (LSB/MSB pairs for X, Y, Z)
-    lsb_x = spi_write(0x00);
-    msb_x = spi_write(0x00);
-    lsb_y = spi_write(0x00);
-    msb_y = spi_write(0x00);
-    lsb_z = spi_write(0x00);
-    msb_z = spi_write(0x00);
-    MAG_CS = 1;                         // Deselect magnetometer
+    // Keep raw 13-bit signed values left aligned (MAG_RAW_SCALE counts per LSB)
+    data.x = ((int16_t)(reg[1] << 8) | (reg[0] & 0xF8));
+    data.y = ((int16_t)(reg[3] << 8) | (reg[2] & 0xF8));
+    data.z = ((int16_t)(reg[5] << 8) | (reg[4] & 0xF8));
+    return data;
+}
 
-    // Convert raw 13-bit signed values to float
-    int16_t raw_x = ((int16_t)(msb_x << 8) | (lsb_x & 0xF8));
-    int16_t raw_y = ((int16_t)(msb_y << 8) | (lsb_y & 0xF8));
-    int16_t raw_z = ((int16_t)(msb_z << 8) | (lsb_z & 0xF8));
-    
-    // Scale values (divide by 8 to get proper units)
-    data.x = (float)raw_x / 8.0f;
-    data.y = (float)raw_y / 8.0f;
-    data.z = (float)raw_z / 8.0f;
+/* Read raw magnetometer data for all axes (blocking) */
+MagRaw read_mag_all(void) {
+    uint8_t reg[6];
 
-    return data;
+    imu_read_regs(&mag_device, MAG_DATA_X_LSB, reg, sizeof(reg));  // LSB/MSB pairs for X, Y, Z
+    return mag_decode(reg);
 }
 
-/* Update moving average buffer with new magnetometer data */
-void update_mag_avg(MagAvgBuffer *buf, MagData new_data) {
-    // Store new data in circular buffer
-    buf->x[buf->idx] = new_data.x;
-    buf->y[buf->idx] = new_data.y;
-    buf->z[buf->idx] = new_data.z;
+/* Sampling counters and sample queue (SPI interrupt -> main loop) */
+volatile MagSampleStats mag_stats;
+static volatile MagSample mag_queue[MAG_QUEUE_SIZE];
+static volatile uint8_t mag_queue_head = 0;   // Written by mag_burst_done
+static volatile uint8_t mag_queue_tail = 0;   // Written by mag_sample_pop
+
+/* Data burst: read command, then dummies clocking out 8 registers */
+static void mag_burst_done(SpiTransaction *t);
+static const uint8_t mag_burst_tx[MAG_BURST_LEN] = { MAG_DATA_X_LSB | 0x80 };
+static uint8_t mag_burst_rx[MAG_BURST_LEN];   // Address echo + 8 data registers
+static volatile uint32_t mag_burst_stamp;     // DRDY edge / request time
+static SpiTransaction mag_burst = {
+    .dev = &mag_device,
+    .tx = mag_burst_tx,
+    .rx = mag_burst_rx,
+    .len = MAG_BURST_LEN,
+    .priority = SPIBUS_PRIO_HIGH,   // Sensor data is only valid until the next DRDY
+    .done = mag_burst_done
+};
+
+/* Enable the sensor's DRDY pin and the INT3 interrupt it is remapped to */
+void mag_drdy_enable(void) {
+    MAG_DRDY_TRIS = 1;                   // DRDY pin as input
+    mag_reg_write(MAG_INT_CTRL, MAG_DRDY_PIN_EN | MAG_DRDY_POL_HIGH);  // Written by mag_config_flush()
     
-    // Update index with wrap-around
-    buf->idx = (buf->idx + 1) % MAG_AVG_WINDOW;
+    INTCON2bits.INT3EP = 0;   // Interrupt on rising edge
+    IFS3bits.INT3IF = 0;      // Clear interrupt flag
+    IEC3bits.INT3IE = 1;      // Enable INT3
 }
 
-/* Calculate averaged magnetometer data from buffer */
-MagData get_avg_mag(const MagAvgBuffer *buf) {
-    MagData avg = {0.0f, 0.0f, 0.0f};
+/* Queue a finished burst if it carries new data (SPI interrupt) */
+static void mag_burst_done(SpiTransaction *t) {
+    uint8_t head = mag_queue_head;
     
-    // Sum all values in buffer
-    for (uint8_t i = 0; i < MAG_AVG_WINDOW; i++) {
-        avg.x += buf->x[i];
-        avg.y += buf->y[i];
-        avg.z += buf->z[i];
+    if (!(mag_burst_rx[1 + MAG_RHALL_LSB - MAG_DATA_X_LSB] & MAG_DRDY_STATUS)) {
+        mag_stats.duplicate++;  // Data registers not updated since the last read
+        return;
+    }
+    if ((uint8_t)(head - mag_queue_tail) == MAG_QUEUE_SIZE) {
+        mag_stats.missed++;     // Main loop is behind, drop the new sample
+        return;
     }
     
-    // Divide by window size to get average
-    avg.x /= MAG_AVG_WINDOW;
-    avg.y /= MAG_AVG_WINDOW;
-    avg.z /= MAG_AVG_WINDOW;
-    
-    return avg;
+    volatile MagSample *slot = &mag_queue[head & MAG_QUEUE_MASK];
+    slot->raw = mag_decode(&mag_burst_rx[1]);
+    slot->stamp = mag_burst_stamp;
+    mag_queue_head = head + 1;  // Publish after the slot is written
+    mag_stats.queued++;
+}
+
+/* Queue the data burst, the bus manager runs it as soon as SPI1 is free */
+bool mag_read_start(void) {
+    if (mag_burst.pending || !mag_cfg.id_ok) {
+        return false;  // Unverified or missing sensor: its registers are not data
+    }
+    mag_burst_stamp = tmr_cycles();
+    return spibus_submit(&mag_burst);
 }
 
-/* Compute yaw angle (in degrees) from magnetometer data */
-float compute_yaw_angle(const MagData *avg) {
-    // Calculate angle using atan2 and convert to degrees
-    return atan2f(avg->y, avg->x) * (180.0f / M_PI);
+/* True while a burst is pending or running */
+bool mag_read_busy(void) {
+    return mag_burst.pending;
 }
 
-/* Send magnetometer data via UART in $MAG,X,Y,Z* format */
-void send_mag_data(const MagData *data) {
-    char buffer[64];
-    // Format data string
-    int len = snprintf(buffer, sizeof(buffer), "$MAG,%.2f,%.2f,%.2f*",
-                      (double)data->x, (double)data->y, (double)data->z);
+/* Take the oldest queued sample */
+bool mag_sample_pop(MagSample *sample) {
+    uint8_t tail = mag_queue_tail;
     
-    if (len <= 0 || len >= sizeof(buffer)) return;
+    if (tail == mag_queue_head) {
+        return false;  // Queue empty
+    }
+    *sample = mag_queue[tail & MAG_QUEUE_MASK];
+    mag_queue_tail = tail + 1;  // Release the slot after copying
+    return true;
+}
+
+/* Accelerometer / gyroscope reads: one pending transaction and latest result per die */
+typedef struct {
+    SpiTransaction txn;
+    uint8_t tx[IMU_BURST_LEN];
+    uint8_t rx[IMU_BURST_LEN];
+    uint8_t lsb_mask;          // Valid bits of the LSB registers
+    volatile bool fresh;       // rx holds an unread result
+} ImuChannel;
+
+static void imu_read_done(SpiTransaction *t) {
+    ((ImuChannel *)t)->fresh = true;
+}
+
+static ImuChannel acc_channel = {
+    .txn = { .dev = &acc_device, .rx = acc_channel.rx, .tx = acc_channel.tx,
+             .len = IMU_BURST_LEN, .priority = SPIBUS_PRIO_NORMAL, .done = imu_read_done },
+    .tx = { ACC_DATA_X_LSB | 0x80 },
+    .lsb_mask = 0xF0            // 12-bit data, low nibble holds flags
+};
+
+static ImuChannel gyr_channel = {
+    .txn = { .dev = &gyr_device, .rx = gyr_channel.rx, .tx = gyr_channel.tx,
+             .len = IMU_BURST_LEN, .priority = SPIBUS_PRIO_LOW, .done = imu_read_done },
+    .tx = { GYR_DATA_X_LSB | 0x80 },
+    .lsb_mask = 0xFF
+};
+
+/* Queue a data read of one die */
+static bool imu_read_start(ImuChannel *ch) {
+    if (ch->txn.pending) {
+        return false;
+    }
+    ch->fresh = false;
+    return spibus_submit(&ch->txn);
+}
+
+/* Decode a completed read, true once per read */
+static bool imu_read(ImuChannel *ch, ImuRaw *data) {
+    if (!ch->fresh || ch->txn.pending) {
+        return false;
+    }
+    const uint8_t *reg = &ch->rx[1];
+    data->x = (int16_t)((reg[1] << 8) | (reg[0] & ch->lsb_mask));
+    data->y = (int16_t)((reg[3] << 8) | (reg[2] & ch->lsb_mask));
+    data->z = (int16_t)((reg[5] << 8) | (reg[4] & ch->lsb_mask));
+    ch->fresh = false;
+    return true;
+}
+
+bool acc_read_start(void) { return imu_read_start(&acc_channel); }
+bool acc_read(ImuRaw *data) { return imu_read(&acc_channel, data); }
+bool gyr_read_start(void) { return imu_read_start(&gyr_channel); }
+bool gyr_read(ImuRaw *data) { return imu_read(&gyr_channel, data); }
+
+/* INT3 interrupt: magnetometer data ready, read it right away */
+void __attribute__((interrupt, no_auto_psv)) _INT3Interrupt(void) {
+    IFS3bits.INT3IF = 0;  // Clear the interrupt flag
     
-    // Critical section for UART transmission
-    IEC0bits.U1TXIE = 0; // Disable UART TX interrupt
-    for (int i = 0; i < len; i++) {
-        UART1_TxBuffer_Write(&uart1_tx, buffer[i]);
+    if (!mag_cfg.id_ok) {
+        return;              // Not sampling until the chip ID matches
+    }
+    if (!mag_read_start()) {
+        mag_stats.missed++;  // Previous burst still running, this sample is lost
     }
-    IEC0bits.U1TXIE = 1; // Re-enable UART TX interrupt
-    IFS0bits.U1TXIF = 1; // Trigger transmit interrupt
 }
 
-/* Send yaw angle via UART in $YAW,ANGLE* format */
-void send_yaw_data(float yaw_angle) {
-    char buffer[32];
-    // Format yaw string
-    int len = snprintf(buffer, sizeof(buffer), "$YAW,%.2f*\n", (double)yaw_angle);
+/* CORDIC angle table: atan(2^-i) in 1/6400 degree units */
+#define CORDIC_STEPS     16
+#define CORDIC_ANGLE_DEG 6400    // Angle units per degree (centi-degree / 64)
+static const int32_t cordic_angle[CORDIC_STEPS] = {
+    288000, 170016, 89832, 45600, 22889, 11455, 5729, 2865,
+    1432, 716, 358, 179, 90, 45, 22, 11
+};
+
+/*
+ * atan2(y, x) in centi-degrees, -18000..18000, by CORDIC vectoring.
+ * Inputs are normalised to 29-30 bits so small vectors keep full precision,
+ * the quadrant is reduced to x >= 0 with a +-90 degree rotation, then 16
+ * shift-add steps drive y to zero. Max error against atan2 is 0.01 degree
+ * (1 centi-degree: final rounding plus the atan(2^-15) residual), swept
+ * over the full circle at radii 1..2^31 by tests/test_atan2.c (worst 0.70).
+ */
+int16_t atan2_cdeg(int32_t y, int32_t x) {
+    int32_t angle = 0;
+    
+    if (x == 0 && y == 0) {
+        return 0;
+    }
     
-    if (len <= 0 || len >= sizeof(buffer)) return;
+    // Normalise: largest magnitude in [2^28, 2^29), gain 1.65 * sqrt(2) still fits
+    uint32_t mag_x = (x < 0) ? 0U - (uint32_t)x : (uint32_t)x;
+    uint32_t mag_y = (y < 0) ? 0U - (uint32_t)y : (uint32_t)y;
+    uint32_t largest = (mag_x > mag_y) ? mag_x : mag_y;
+    while (largest >= (1UL << 29)) {
+        x >>= 1;
+        y >>= 1;
+        largest >>= 1;
+    }
+    while (largest < (1UL << 28)) {
+        x *= 2;
+        y *= 2;
+        largest <<= 1;
+    }
+    
+    // Rotate left half plane by -90/+90 degrees into x >= 0
+    if (x < 0) {
+        int32_t t = x;
+        if (y >= 0) {
+            x = y;
+            y = -t;
+            angle = 90L * CORDIC_ANGLE_DEG;
+        } else {
+            x = -y;
+            y = t;
+            angle = -90L * CORDIC_ANGLE_DEG;
+        }
+    }
     
-    // Critical section for UART transmission
-    IEC0bits.U1TXIE = 0; // Disable UART TX interrupt
-    for (int i = 0; i < len; i++) {
-        UART1_TxBuffer_Write(&uart1_tx, buffer[i]);
+    // Vectoring: rotate towards y = 0, accumulating the rotation
+    for (uint8_t i = 0; i < CORDIC_STEPS; i++) {
+        int32_t dx = y >> i;
+        int32_t dy = x >> i;
+        if (y > 0) {
+            x += dx;
+            y -= dy;
+            angle += cordic_angle[i];
+        } else {
+            x -= dx;
+            y += dy;
+            angle -= cordic_angle[i];
+        }
     }
-    IEC0bits.U1TXIE = 1; // Re-enable UART TX interrupt
-    IFS0bits.U1TXIF = 1; // Trigger transmit interrupt
+    
+    // 1/6400 degree to centi-degree, rounded half away from zero
+    angle = (angle >= 0) ? (angle + 32) >> 6 : -((32 - angle) >> 6);
+    return (int16_t)angle;
 }
 
+/* Compute yaw angle (in centi-degrees) from magnetometer data */
+int16_t compute_yaw_angle(const MagData *avg) {
+#if MAG_INTEGER_PIPELINE
+    return atan2_cdeg(avg->y, avg->x);
+#else
+    // Calculate angle using atan2 and convert to centi-degrees
+    float cdeg = atan2f(avg->y, avg->x) * (18000.0f / M_PI);
+    return (int16_t)(cdeg >= 0.0f ? cdeg + 0.5f : cdeg - 0.5f);
+#endif
+}
@@ -9,56 +9,196 @@
 #define	SPI_H
 
 #include "uart.h"
+#include "spibus.h"
 #include "math.h"
 
 #ifdef	__cplusplus
 extern "C" {
 #endif
 
-// Magnetometer Chip Select (CS) Pin
+// Chip Select (CS) Pins on SPI1, active low
 #define MAG_CS LATDbits.LATD6
+#define MAG_CS_LAT    LATD
+#define MAG_CS_MASK   (1U << 6)
+
+// Accelerometer and gyroscope dies of the BMX055, board-specific: RB3 / RB4
+#define ACC_CS_TRIS   TRISBbits.TRISB3
+#define ACC_CS_LAT    LATB
+#define ACC_CS_MASK   (1U << 3)
+#define GYR_CS_TRIS   TRISBbits.TRISB4
+#define GYR_CS_LAT    LATB
+#define GYR_CS_MASK   (1U << 4)
+
+// Bus settings shared by the three dies: mode 3, 4.5MHz (PPRE 4:1, SPRE 4:1)
+#define IMU_SPI_MODE  3
+#define IMU_SPI_PPRE  1
+#define IMU_SPI_SPRE  4
+
+// Magnetometer data-ready pin, board-specific: RE6 (RPI86) remapped to INT3
+#define MAG_DRDY_TRIS TRISEbits.TRISE6
+#define MAG_DRDY_RPI  0x56
+
+// Sampling: 1 = burst on every DRDY edge (INT3), 0 = burst every DATA_READ_TICKS
+#ifndef MAG_SAMPLING_DRDY
+#define MAG_SAMPLING_DRDY 1
+#endif
     
-// Moving average buffer size
-#define MAG_AVG_WINDOW 5 
+// Magnetometer pipeline: 1 = integer (int16 samples, Q16.16 output), 0 = float
+#ifndef MAG_INTEGER_PIPELINE
+#define MAG_INTEGER_PIPELINE 1
+#endif
+
+// Raw register values are the reading << 3, one sensor LSB is MAG_RAW_SCALE counts
+#define MAG_RAW_SCALE 8
+
     
 // Magnetometer Register Addresses
 #define MAG_POWER_CTRL 0x4B  // Power mode control
 #define MAG_CTRL_REG2  0x4C  // Configuration register
 #define MAG_CHIP_ID    0x40  // Device ID
 #define MAG_DATA_X_LSB 0x42  // X-axis data LSB
+#define MAG_RHALL_LSB  0x48  // Hall resistance LSB, bit 0 = data ready status
+#define MAG_INT_CTRL   0x4E  // Interrupt and DRDY pin control
+#define MAG_REP_XY     0x51  // X/Y repetitions
+#define MAG_REP_Z      0x52  // Z repetitions
+
+#define MAG_CHIP_ID_VALUE 0x32  // MAG_CHIP_ID once out of suspend (reads 0x00 in suspend)
+
+#define MAG_DRDY_STATUS   0x01  // MAG_RHALL_LSB: new data since the last read
+#define MAG_DRDY_PIN_EN   0x80  // MAG_INT_CTRL: enable the DRDY pin
+#define MAG_DRDY_POL_HIGH 0x04  // MAG_INT_CTRL: DRDY active high
+
+// Shadowed configuration registers: MAG_POWER_CTRL..MAG_REP_Z, one dirty bit each
+#define MAG_SHADOW_FIRST   MAG_POWER_CTRL
+#define MAG_SHADOW_COUNT   (MAG_REP_Z - MAG_POWER_CTRL + 1)
+#define MAG_SETTLE_POWER_US 3000  // Suspend -> sleep start-up before other registers respond
+#define MAG_ID_RETRIES     3      // Chip ID mismatches before the sensor is given up
+
+// Data burst: address byte + X/Y/Z LSB/MSB + RHALL LSB/MSB (for the DRDY status)
+#define MAG_BURST_LEN  9
+
+// Accelerometer / gyroscope data registers (X/Y/Z LSB/MSB from 0x02)
+#define ACC_DATA_X_LSB 0x02
+#define GYR_DATA_X_LSB 0x02
+#define IMU_BURST_LEN  7     // Address byte + 6 data registers
+
+// SPI1 enhanced buffer depth
+#define SPI_FIFO_DEPTH 8
+
+// Sample queue between the SPI interrupt and the main loop (power of two)
+#define MAG_QUEUE_SIZE 8
+#define MAG_QUEUE_MASK (MAG_QUEUE_SIZE - 1)
  
 /* Data Structures */
-// Raw magnetometer data (X, Y, Z axes)
+// Raw magnetometer registers (X, Y, Z axes, MAG_RAW_SCALE counts per LSB)
 typedef struct {
-    float x;  
-    float y;
-    float z;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} MagRaw;
+
+#if MAG_INTEGER_PIPELINE
+typedef int32_t mag_value_t;   // Q16.16 sensor LSB
+#else
+typedef float mag_value_t;     // Sensor LSB
+#endif
+
+// Magnetometer data in sensor LSB (X, Y, Z axes)
+typedef struct {
+    mag_value_t x;  
+    mag_value_t y;
+    mag_value_t z;
 } MagData;
 
-// Buffer for storing magnetometer data for moving average.
+// Queued sample, stamp is tmr_cycles() at the DRDY edge (or burst start)
+typedef struct {
+    MagRaw raw;
+    uint32_t stamp;
+} MagSample;
+
+// Chip ID check result, reported in $STAT
+typedef enum {
+    MAG_CHIP_PENDING = 0,   // Not read since power-up, or a retry is on its way
+    MAG_CHIP_OK = 1,        // Read MAG_CHIP_ID_VALUE
+    MAG_CHIP_FAILED = 2     // Still wrong after MAG_ID_RETRIES rewrites, sensor given up
+} MagChipState;
+
+// Sampling counters
+typedef struct {
+    uint16_t queued;      // New samples queued
+    uint16_t missed;      // DRDY edges lost (burst still running) or queue full
+    uint16_t duplicate;   // Bursts that read no new data (DRDY status clear)
+} MagSampleStats;
+
+extern volatile MagSampleStats mag_stats;
+
+// Accelerometer (12-bit, left aligned) or gyroscope (16-bit) axes
 typedef struct {
-    float x[MAG_AVG_WINDOW];  
-    float y[MAG_AVG_WINDOW];
-    float z[MAG_AVG_WINDOW];
-    uint8_t idx;
-} MagAvgBuffer;
+    int16_t x;
+    int16_t y;
+    int16_t z;
+} ImuRaw;
+
+// SPI1 devices
+extern const SpiDevice mag_device;
+extern const SpiDevice acc_device;
+extern const SpiDevice gyr_device;
+
+// Asynchronous transfer completion, runs in the SPI interrupt: keep it short
+typedef void (*SpiDoneCallback)(void);
 
 /* SPI Functions */
-void spi_init(void);                // Initialize SPI
-uint16_t spi_write(uint16_t data);  // Write 16-bit data
+void spi_init(void);                // Initialize SPI (enhanced buffer mode), all CS released
+uint16_t spi_write(uint16_t data);  // Write one byte, return the byte received
+void spi_transfer(const uint8_t *tx, uint8_t *rx, uint16_t len);  // Blocking burst, tx NULL sends 0x00, rx NULL discards
+bool spi_transfer_start(const uint8_t *tx, uint8_t *rx, uint16_t len, SpiDoneCallback done);  // Interrupt-driven burst, false if busy
+bool spi_busy(void);                // Asynchronous burst in progress
+
+/*
+ * Configuration cache: mag_reg_write() only updates the shadow copy and
+ * marks the register dirty when the value changes. mag_config_flush() is
+ * polled from the main loop and never waits: it writes dirty registers as
+ * address/value pairs in one CS-held burst on the bus manager, sets a
+ * settle deadline after a power control write and reads the chip ID once
+ * the sensor is powered. An ID mismatch means the sensor lost its
+ * configuration (e.g. brown-out back to suspend), so every cached
+ * register is written again. Data bursts are only started while the ID
+ * matches.
+ */
+bool mag_reg_write(uint8_t reg, uint8_t value);  // False if reg is not shadowed
+bool mag_config_flush(void);       // True once the cache is written, settled and the ID matched
+bool mag_config_ready(void);       // Settle deadline passed, no flush running
+bool mag_chip_ok(void);            // Chip ID matched MAG_CHIP_ID_VALUE
+MagChipState mag_chip_state(void); // Pending, ok or given up
 
 /* Magnetometer Functions */
-void mag_sleep(void);              // Enter sleep mode
-void mag_active(void);             // Wake up magnetometer
-uint8_t read_chip_id(void);        // Read device ID
-MagData read_mag_all(void);        // Read X, Y, Z data
-void update_mag_avg(MagAvgBuffer *buf, MagData new_data);  // Update moving average
-MagData get_avg_mag(const MagAvgBuffer *buf);  // Get averaged data
-float compute_yaw_angle(const MagData *avg);   // Calculate yaw (degrees)
-
-/* Communication Functions */
-void send_mag_data(const MagData *data);    // Send Magnetometer data via UART
-void send_yaw_data(float yaw_angle);        // Send yaw angle via UART
+void mag_sleep(void);              // Enter sleep mode (cached)
+void mag_active(void);             // Wake up magnetometer (cached)
+uint8_t read_chip_id(void);        // Last chip ID read by mag_config_flush(), 0 before
+MagRaw read_mag_all(void);         // Read X, Y, Z data (blocking)
+
+/*
+ * Asynchronous data read: mag_read_start() queues the burst on the SPI bus
+ * manager at high priority, the completion (SPI interrupt) decodes it.
+ * Samples with the DRDY status set are queued once with their timestamp,
+ * re-reads of old data only count as duplicates.
+ * In DRDY mode _INT3Interrupt starts the burst on every data-ready edge.
+ * The blocking SPI functions must only be used while spibus_idle().
+ */
+void mag_drdy_enable(void);                    // Sensor DRDY pin (cached) and INT3
+bool mag_read_start(void);                     // False if a burst is pending or the chip ID is not ok
+bool mag_read_busy(void);                      // Burst pending or running
+bool mag_sample_pop(MagSample *sample);        // Oldest queued sample, false if none
+
+/* Accelerometer / Gyroscope Functions (asynchronous, shared bus) */
+bool acc_read_start(void);                     // Queue a data read, false if one is pending
+bool acc_read(ImuRaw *data);                   // True once per completed read
+bool gyr_read_start(void);
+bool gyr_read(ImuRaw *data);
+int16_t compute_yaw_angle(const MagData *avg); // Calculate yaw (centi-degrees)
+
+/* Heading Kernel */
+int16_t atan2_cdeg(int32_t y, int32_t x);      // Integer atan2 in centi-degrees, error <= 1 centi-degree
 
 #ifdef	__cplusplus
 }
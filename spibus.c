@@ -0,0 +1,198 @@
+#include "spibus.h"
+#include "spi.h"
+
+/* Queue of pending transactions (intrusive list, oldest first) */
+static SpiTransaction *queue_head = NULL;
+static SpiTransaction *queue_tail = NULL;
+static SpiTransaction *volatile active = NULL;   // Transaction on the wire
+
+/* Bus statistics */
+volatile SpiBusStats spibus_stats;
+static uint32_t cs_start;                        // tmr_cycles() at CS assert
+static volatile uint32_t busy_cycles = 0;        // CS held since the last load sample
+static uint32_t load_since = 0;                  // tmr_cycles() at the last load sample
+
+/* Settings SPI1 currently runs with */
+static struct {
+    bool valid;                                  // Set once by the first configure
+    uint8_t mode;
+    uint8_t ppre;
+    uint8_t spre;
+} configured;
+
+/* Keep the queue consistent against the SPI and INT3 interrupts */
+static bool spibus_lock(void) {
+    bool gie = INTCON2bits.GIE;
+    INTCON2bits.GIE = 0;
+    return gie;
+}
+
+static void spibus_unlock(bool gie) {
+    INTCON2bits.GIE = gie;
+}
+
+/* Apply mode and clock of dev, SPI must be idle. Devices sharing settings skip the SPIEN cycle */
+static void spibus_configure(const SpiDevice *dev) {
+    if (configured.valid && configured.mode == dev->mode &&
+        configured.ppre == dev->ppre && configured.spre == dev->spre) {
+        return;
+    }
+    SPI1STATbits.SPIEN = 0;                 // Settings only change while disabled
+    SPI1CON1bits.CKP = (dev->mode >> 1) & 1;
+    SPI1CON1bits.CKE = !(dev->mode & 1);    // CKE=1 samples on the leading edge (CPHA=0)
+    SPI1CON1bits.PPRE = dev->ppre;
+    SPI1CON1bits.SPRE = dev->spre;
+    SPI1STATbits.SPIEN = 1;
+    configured.valid = true;
+    configured.mode = dev->mode;
+    configured.ppre = dev->ppre;
+    configured.spre = dev->spre;
+}
+
+/* Apply settings and assert CS */
+void spibus_select(const SpiDevice *dev) {
+    spibus_configure(dev);
+    *dev->cs_lat &= ~dev->cs_mask;
+    cs_start = tmr_cycles();
+}
+
+/* Release CS and account the hold time */
+void spibus_deselect(const SpiDevice *dev) {
+    *dev->cs_lat |= dev->cs_mask;
+    uint32_t hold = tmr_cycles() - cs_start;
+    
+    busy_cycles += hold;
+    spibus_stats.cs_hold_last = hold;
+    if (hold > spibus_stats.cs_hold_max) {
+        spibus_stats.cs_hold_max = hold;
+    }
+}
+
+/* Remove and return the next transaction: best priority, oldest first, aged ones first of all */
+static SpiTransaction *spibus_take(void) {
+    SpiTransaction *best = NULL, *best_prev = NULL, *prev = NULL;
+    uint8_t best_prio = 0xFF;
+    
+    for (SpiTransaction *t = queue_head; t != NULL; prev = t, t = t->next) {
+        uint8_t prio = (t->waits >= SPIBUS_MAX_WAITS) ? 0 : t->priority + 1;
+        if (prio < best_prio) {
+            best = t;
+            best_prev = prev;
+            best_prio = prio;
+        }
+    }
+    if (best == NULL) {
+        return NULL;
+    }
+    
+    // Unlink, everyone still queued was passed over once more
+    if (best_prev == NULL) {
+        queue_head = best->next;
+    } else {
+        best_prev->next = best->next;
+    }
+    if (queue_tail == best) {
+        queue_tail = best_prev;
+    }
+    for (SpiTransaction *t = queue_head; t != NULL; t = t->next) {
+        if (t->waits < SPIBUS_MAX_WAITS) {
+            t->waits++;
+        }
+    }
+    if (best_prio == 0) {
+        spibus_stats.promoted++;
+    }
+    return best;
+}
+
+static void spibus_complete(void);
+
+/* Start the next queued transaction if the bus is free (lock held) */
+static void spibus_kick(void) {
+    while (active == NULL) {
+        SpiTransaction *t = spibus_take();
+        if (t == NULL) {
+            return;
+        }
+        active = t;
+        spibus_select(t->dev);
+        t->stamp = cs_start;
+        if (spi_transfer_start(t->tx, t->rx, t->len, spibus_complete)) {
+            return;
+        }
+        // Zero length or SPI used directly: finish it here
+        spibus_deselect(t->dev);
+        active = NULL;
+        t->pending = false;
+        if (t->done != NULL) {
+            t->done(t);
+        }
+    }
+}
+
+/* SPI interrupt: transaction finished, release CS and start the next one back to back */
+static void spibus_complete(void) {
+    SpiTransaction *t = active;
+    
+    spibus_deselect(t->dev);
+    spibus_stats.transactions++;
+    active = NULL;
+    t->pending = false;
+    if (t->done != NULL) {
+        t->done(t);
+    }
+    
+    bool gie = spibus_lock();
+    spibus_kick();
+    spibus_unlock(gie);
+}
+
+/* Queue a transaction and start it if the bus is free */
+bool spibus_submit(SpiTransaction *t) {
+    bool gie = spibus_lock();
+    
+    if (t->pending) {
+        spibus_unlock(gie);
+        return false;
+    }
+    t->pending = true;
+    t->waits = 0;
+    t->next = NULL;
+    if (queue_tail == NULL) {
+        queue_head = t;
+    } else {
+        queue_tail->next = t;
+    }
+    queue_tail = t;
+    
+    spibus_kick();
+    spibus_unlock(gie);
+    return true;
+}
+
+/* Nothing queued or running */
+bool spibus_idle(void) {
+    return active == NULL && queue_head == NULL;
+}
+
+/* Share of time CS was held since the last call, in permille */
+uint16_t spibus_load_permille(void) {
+    bool gie = spibus_lock();
+    uint32_t now = tmr_cycles();
+    uint32_t busy = busy_cycles;
+    busy_cycles = 0;
+    spibus_unlock(gie);
+    
+    uint32_t elapsed = now - load_since;
+    load_since = now;
+    if (elapsed == 0) {
+        return 0;
+    }
+    // Scale both down so busy * 1000 fits in 32 bits
+    while (elapsed > 0x3FFFFFUL) {
+        elapsed >>= 1;
+        busy >>= 1;
+    }
+    uint32_t load = busy * 1000 / elapsed;
+    return (load > 1000) ? 1000 : (uint16_t)load;
+}
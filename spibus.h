@@ -0,0 +1,81 @@
+/*
+ * File:   spibus.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 8:30 PM
+ */
+
+#ifndef SPIBUS_H
+#define	SPIBUS_H
+
+#include "config.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Passes over a queued transaction before it is served ahead of all priorities
+#define SPIBUS_MAX_WAITS 4
+
+// Transaction priorities (lower is served first)
+#define SPIBUS_PRIO_HIGH 0
+#define SPIBUS_PRIO_NORMAL 1
+#define SPIBUS_PRIO_LOW 2
+
+// Device on SPI1: chip select and bus settings applied while it is selected
+typedef struct {
+    volatile uint16_t *cs_lat;   // LAT register of the CS pin (active low)
+    uint16_t cs_mask;            // CS bit in that register
+    uint8_t mode;                // SPI mode 0-3 (CPOL << 1 | CPHA)
+    uint8_t ppre;                // SPI1CON1 PPRE (primary prescaler)
+    uint8_t spre;                // SPI1CON1 SPRE (secondary prescaler)
+} SpiDevice;
+
+typedef struct SpiTransaction SpiTransaction;
+
+// Completion, runs in the SPI interrupt: keep it short, may submit again
+typedef void (*SpiTransactionDone)(SpiTransaction *t);
+
+/*
+ * Queued bus transaction, owned by the bus manager from spibus_submit()
+ * until done is called. CS is held for the whole transfer.
+ */
+struct SpiTransaction {
+    const SpiDevice *dev;
+    const uint8_t *tx;           // NULL: send 0x00
+    uint8_t *rx;                 // NULL: discard
+    uint16_t len;
+    uint8_t priority;            // SPIBUS_PRIO_*
+    SpiTransactionDone done;     // May be NULL
+    uint32_t stamp;              // tmr_cycles() when CS was asserted
+    
+    // Bus manager state
+    volatile bool pending;       // Queued or running
+    uint8_t waits;               // Times another transaction went first
+    SpiTransaction *next;
+};
+
+// Bus counters, cycles are tmr_cycles() units
+typedef struct {
+    uint16_t transactions;       // Completed transactions
+    uint16_t promoted;           // Transactions served early by ageing
+    uint32_t cs_hold_last;       // CS hold time of the last transaction
+    uint32_t cs_hold_max;        // Worst CS hold time
+} SpiBusStats;
+
+extern volatile SpiBusStats spibus_stats;
+
+/* Bus Manager Functions */
+bool spibus_submit(SpiTransaction *t);          // Queue, false if t is still pending
+bool spibus_idle(void);                         // Nothing queued or running
+uint16_t spibus_load_permille(void);            // Bus busy time since the last call (0-1000)
+
+/* Blocking access (initialisation, bus must be idle) */
+void spibus_select(const SpiDevice *dev);       // Apply settings and assert CS
+void spibus_deselect(const SpiDevice *dev);     // Release CS, record the hold time
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPIBUS_H */
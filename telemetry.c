@@ -0,0 +1,252 @@
+#include "telemetry.h"
+#include "format.h"
+
+/* Binary encoder state */
+static TelemetryMode tlm_mode = TLM_MODE_ASCII;   // Selected output format
+static uint8_t tlm_seq = 0;                       // Binary frame sequence number
+static int16_t tlm_prev[3];                       // Last MAG sample the receiver holds
+static uint8_t tlm_since_key = TLM_KEYFRAME_EVERY;  // Deltas since last absolute frame
+static uint16_t tlm_dropped_seen = 0;             // Binary stream drops already answered with a keyframe
+
+/* Select telemetry output format */
+bool telemetry_set_mode(uint8_t mode) {
+    if (mode >= TLM_MODE_COUNT) {
+        return false;
+    }
+    tlm_mode = (TelemetryMode)mode;
+    tlm_since_key = TLM_KEYFRAME_EVERY;  // Restart deltas from an absolute frame
+    UART1_SetTextDelimiter(tlm_mode != TLM_MODE_ASCII);  // Keep text apart from COBS frames
+    return true;
+}
+
+/* Get telemetry output format */
+TelemetryMode telemetry_get_mode(void) {
+    return tlm_mode;
+}
+
+/* CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) */
+uint16_t crc16_ccitt(const uint8_t *data, uint16_t len) {
+    uint16_t crc = 0xFFFF;
+    
+    while (len--) {
+        crc ^= (uint16_t)(*data++) << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+/* COBS encode len bytes (dst needs len + len/254 + 1 bytes), returns encoded length */
+uint16_t cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst) {
+    uint16_t code_idx = 0;   // Where the current block's code byte goes
+    uint16_t out = 1;
+    uint8_t code = 1;        // Distance to the next zero
+    
+    for (uint16_t i = 0; i < len; i++) {
+        if (src[i] == 0) {
+            dst[code_idx] = code;   // Close block at the zero
+            code_idx = out++;
+            code = 1;
+        } else {
+            dst[out++] = src[i];
+            code++;
+            if (code == 0xFF) {     // Maximum block length reached
+                dst[code_idx] = code;
+                code_idx = out++;
+                code = 1;
+            }
+        }
+    }
+    dst[code_idx] = code;
+    return out;
+}
+
+/* Telemetry streams: stale samples are worth less than fresh ones */
+UART_TxStream mag_stream = { .policy = TX_DROP_OLDEST };
+UART_TxStream yaw_stream = { .policy = TX_DROP_OLDEST };
+
+/* ASCII frame being built in the TX ring (or on the stack across the wrap) */
+typedef struct {
+    UART_Span span[2];
+    uint8_t spans;            // Reserved spans, 0 if the frame is not queued
+    char *out;                // Where the text goes
+    uint16_t len;
+    uint16_t max_len;         // Same rule as snprintf: len < max_len
+    char buffer[TX_FRAME_MAX];
+} TxFrame;
+
+/* Reserve room for the longest frame so it is queued whole or not at all */
+static bool frame_begin(TxFrame *f, UART_TxStream *stream, uint16_t max_len) {
+    f->spans = 0;
+    if (max_len > sizeof(f->buffer)) return false;
+    
+    f->spans = UART1_TxBuffer_ReserveFrame(&uart1_tx, stream, max_len, f->span);
+    // Contiguous: format in place, otherwise format once and copy at the end
+    f->out = (f->spans == 1) ? (char *)f->span[0].ptr : f->buffer;
+    f->len = 0;
+    f->max_len = max_len;
+    return f->spans != 0;
+}
+
+/* Append n bytes, a frame that overflows is dropped */
+static void frame_append(TxFrame *f, const char *str, uint8_t n) {
+    if (f->spans == 0) return;
+    if (f->len + n >= f->max_len) {
+        f->spans = 0;
+        return;
+    }
+    memcpy(&f->out[f->len], str, n);
+    f->len += n;
+}
+
+/* Append text */
+static void frame_text(TxFrame *f, const char *str) {
+    frame_append(f, str, strlen(str));
+}
+
+/* Append a two-decimal number, length 0 means not representable */
+static void frame_number(TxFrame *f, const char *number, uint8_t n) {
+    if (n == 0) {
+        f->spans = 0;
+        return;
+    }
+    frame_append(f, number, n);
+}
+
+/* Append a magnetometer axis value */
+static void frame_mag(TxFrame *f, mag_value_t value) {
+    char number[FMT_FIXED2_MAX];
+#if MAG_INTEGER_PIPELINE
+    frame_number(f, number, fmt_q16(number, value));
+#else
+    frame_number(f, number, fmt_float(number, value));
+#endif
+}
+
+/* Append a value given in hundredths */
+static void frame_centi(TxFrame *f, int16_t value) {
+    char number[FMT_FIXED2_MAX];
+    frame_number(f, number, fmt_centi(number, value));
+}
+
+/* Commit the frame (dropped if anything failed) and start transmission */
+static void frame_end(TxFrame *f, UART_TxStream *stream) {
+    if (f->spans == 2) {
+        uint16_t first = (f->len < f->span[0].len) ? f->len : f->span[0].len;
+        memcpy(f->span[0].ptr, f->buffer, first);
+        memcpy(f->span[1].ptr, &f->buffer[first], f->len - first);
+    }
+    if (f->spans != 0 && f->len > 0) {
+        UART1_TxBuffer_CommitFrame(&uart1_tx, stream, f->len);
+    }
+    UART1_TxBuffer_Start(&uart1_tx);  // Trigger transmission
+}
+
+/* Round a magnetometer value to the nearest sensor LSB (half away from zero) */
+static int16_t round_mag(mag_value_t value) {
+#if MAG_INTEGER_PIPELINE
+    return (int16_t)(value >= 0 ? (value + 0x8000) >> 16 : -((0x8000 - value) >> 16));
+#else
+    return (int16_t)(value >= 0.0f ? value + 0.5f : value - 0.5f);
+#endif
+}
+
+/* Append CRC, COBS encode and queue one binary frame */
+static bool send_binary(UART_TxStream *stream, uint8_t type, const uint8_t *data, uint8_t len) {
+    uint8_t payload[TLM_PAYLOAD_MAX];
+    uint8_t frame[TLM_FRAME_MAX];
+    
+    payload[0] = type;
+    payload[1] = tlm_seq++;
+    memcpy(&payload[2], data, len);
+    len += 2;
+    
+    uint16_t crc = crc16_ccitt(payload, len);
+    payload[len++] = (uint8_t)crc;
+    payload[len++] = (uint8_t)(crc >> 8);
+    
+    uint16_t frame_len = cobs_encode(payload, len, frame);
+    frame[frame_len++] = 0x00;  // Frame delimiter
+    
+    bool queued = UART1_TxBuffer_WriteFrame(&uart1_tx, stream, frame, frame_len);
+    UART1_TxBuffer_Start(&uart1_tx);  // Trigger transmission
+    return queued;
+}
+
+/* Send magnetometer data as a binary MAG or MAG_DELTA frame */
+static void send_mag_binary(const MagData *data) {
+    int16_t axis[3] = { round_mag(data->x), round_mag(data->y), round_mag(data->z) };
+    uint8_t buf[6];
+    
+    // A queued frame was evicted since the last sample (possibly the delta
+    // reference, and SEQ is shared with yaw): restart from an absolute frame
+    uint16_t dropped = mag_stream.frames_dropped + yaw_stream.frames_dropped;
+    if (dropped != tlm_dropped_seen) {
+        tlm_dropped_seen = dropped;
+        tlm_since_key = TLM_KEYFRAME_EVERY;
+    }
+    
+    bool delta = (tlm_mode == TLM_MODE_BINARY_DELTA) && (tlm_since_key < TLM_KEYFRAME_EVERY);
+    
+    // Fall back to an absolute frame if any delta does not fit in int8
+    for (uint8_t i = 0; i < 3 && delta; i++) {
+        int16_t d = axis[i] - tlm_prev[i];
+        delta = (d >= INT8_MIN && d <= INT8_MAX);
+    }
+    
+    bool queued;
+    if (delta) {
+        for (uint8_t i = 0; i < 3; i++) {
+            buf[i] = (uint8_t)(int8_t)(axis[i] - tlm_prev[i]);
+        }
+        queued = send_binary(&mag_stream, TLM_TYPE_MAG_DELTA, buf, 3);
+        tlm_since_key++;
+    } else {
+        for (uint8_t i = 0; i < 3; i++) {
+            buf[2 * i] = (uint8_t)axis[i];
+            buf[2 * i + 1] = (uint8_t)((uint16_t)axis[i] >> 8);
+        }
+        queued = send_binary(&mag_stream, TLM_TYPE_MAG, buf, 6);
+        tlm_since_key = 0;
+    }
+    
+    if (queued) {
+        memcpy(tlm_prev, axis, sizeof(tlm_prev));
+    } else {
+        tlm_since_key = TLM_KEYFRAME_EVERY;  // Receiver lost the reference
+    }
+}
+
+/* Send magnetometer data via UART in the selected format */
+void send_mag_data(const MagData *data) {
+    if (tlm_mode != TLM_MODE_ASCII) {
+        send_mag_binary(data);
+        return;
+    }
+    TxFrame frame;
+    frame_begin(&frame, &mag_stream, MAG_FRAME_MAX);
+    frame_text(&frame, "$MAG,");
+    frame_mag(&frame, data->x);
+    frame_text(&frame, ",");
+    frame_mag(&frame, data->y);
+    frame_text(&frame, ",");
+    frame_mag(&frame, data->z);
+    frame_text(&frame, "*");
+    frame_end(&frame, &mag_stream);
+}
+
+/* Send yaw angle (centi-degrees) via UART in the selected format */
+void send_yaw_data(int16_t yaw_cdeg) {
+    if (tlm_mode != TLM_MODE_ASCII) {
+        uint8_t buf[2] = { (uint8_t)yaw_cdeg, (uint8_t)((uint16_t)yaw_cdeg >> 8) };
+        send_binary(&yaw_stream, TLM_TYPE_YAW, buf, 2);
+        return;
+    }
+    TxFrame frame;
+    frame_begin(&frame, &yaw_stream, YAW_FRAME_MAX);
+    frame_text(&frame, "$YAW,");
+    frame_centi(&frame, yaw_cdeg);
+    frame_text(&frame, "*\n");
+    frame_end(&frame, &yaw_stream);
+}
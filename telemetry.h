@@ -0,0 +1,92 @@
+/*
+ * File:   telemetry.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 10:12 AM
+ */
+
+#ifndef TELEMETRY_H
+#define	TELEMETRY_H
+
+#include "spi.h"
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+// Telemetry frame size limits (worst case + string terminator)
+#define MAG_FRAME_MAX  40  // $MAG,-4096.00,-4096.00,-4096.00*
+#define YAW_FRAME_MAX  20  // $YAW,-180.00*\n
+#define TX_FRAME_MAX   40  // Largest ASCII frame built in a TxFrame
+
+// Selectable $MAG rates in Hz ($RATE,n*), 0 disables the stream
+#define MAG_VALID_RATES(X) X(0) X(1) X(2) X(4) X(5) X(10)
+#define YAW_RATE_HZ        (1000 / YAW_SEND_INTERVAL_MS)
+
+/*
+ * Link budget: worst-case (ASCII) telemetry for every $RATE setting
+ * together with the yaw stream must fit in TLM_LINK_BUDGET_PCT of the
+ * UART capacity, leaving the rest for command replies. Raising a rate or
+ * lowering BAUDRATE past the limit fails the build.
+ */
+#define TLM_LINK_BUDGET_PCT 80
+#define TLM_BYTES_PER_SEC(mag_hz, yaw_hz) \
+    ((uint32_t)(mag_hz) * (MAG_FRAME_MAX - 1) + (uint32_t)(yaw_hz) * (YAW_FRAME_MAX - 1))
+#define TLM_BUDGET_CHECK(hz) \
+    STATIC_ASSERT(TLM_BYTES_PER_SEC(hz, YAW_RATE_HZ) * 100 <= \
+                  (uint32_t)UART_BYTES_PER_SEC * TLM_LINK_BUDGET_PCT, tlm_budget_##hz##_hz);
+MAG_VALID_RATES(TLM_BUDGET_CHECK)
+
+/*
+ * Binary telemetry frames
+ *
+ * Payload (little-endian): TYPE(1) SEQ(1) DATA(n) CRC16(2)
+ *   TLM_TYPE_MAG        DATA = int16 x, y, z (sensor LSB)
+ *   TLM_TYPE_MAG_DELTA  DATA = int8 dx, dy, dz against the previous MAG sample
+ *   TLM_TYPE_YAW        DATA = int16 yaw (centi-degrees)
+ * CRC is CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) over TYPE..DATA.
+ * The payload is COBS encoded and terminated by a single 0x00 byte.
+ * SEQ increments on every binary frame; after a gap the decoder must
+ * ignore deltas until the next absolute MAG frame. Any dropped binary
+ * frame forces the next MAG frame to be absolute.
+ * Text messages in binary mode end with 0x00 too (UART1_SendText).
+ */
+#define TLM_TYPE_MAG        0x01
+#define TLM_TYPE_MAG_DELTA  0x02
+#define TLM_TYPE_YAW        0x03
+#define TLM_KEYFRAME_EVERY  16    // Absolute MAG frame at least this often
+#define TLM_PAYLOAD_MAX     10    // TYPE + SEQ + 3*int16 + CRC
+#define TLM_FRAME_MAX       (TLM_PAYLOAD_MAX + TLM_PAYLOAD_MAX / 254 + 2)  // COBS + delimiter
+
+// A COBS code byte can never be mistaken for the '$' that starts a text message
+STATIC_ASSERT(TLM_PAYLOAD_MAX + 1 < '$', tlm_code_not_text);
+
+// Telemetry output modes ($MODE,n*)
+typedef enum {
+    TLM_MODE_ASCII = 0,       // $MAG,X,Y,Z* / $YAW,ANGLE* text frames
+    TLM_MODE_BINARY,          // COBS frames, absolute samples
+    TLM_MODE_BINARY_DELTA,    // COBS frames, delta-encoded samples
+    TLM_MODE_COUNT
+} TelemetryMode;
+
+/* Telemetry Streams */
+extern UART_TxStream mag_stream;   // $MAG frames
+extern UART_TxStream yaw_stream;   // $YAW frames
+
+/* Mode Selection */
+bool telemetry_set_mode(uint8_t mode);  // Returns false for unknown modes
+TelemetryMode telemetry_get_mode(void);
+
+/* Framing Helpers */
+uint16_t crc16_ccitt(const uint8_t *data, uint16_t len);
+uint16_t cobs_encode(const uint8_t *src, uint16_t len, uint8_t *dst);
+
+/* Communication Functions */
+void send_mag_data(const MagData *data);    // Send Magnetometer data via UART
+void send_yaw_data(int16_t yaw_cdeg);       // Send yaw angle (centi-degrees) via UART
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TELEMETRY_H */
@@ -0,0 +1,35 @@
+/*
+ * File:   bench.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+#ifndef BENCH_H
+#define	BENCH_H
+
+#include <stdint.h>
+#include <time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/* Host cycle counter (TSC on x86, 0 elsewhere) and a monotonic ns clock */
+static inline uint64_t bench_cycles(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+static inline uint64_t bench_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/* Keeps a result alive so the measured loop is not optimised away */
+static volatile uint32_t bench_sink;
+
+#endif	/* BENCH_H */
@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "format.h"
+
+/* Cycles per call of each formatter against snprintf on the same inputs */
+#define CALLS 1000000
+
+static int32_t input[CALLS];
+
+typedef struct {
+    const char *name;
+    double fmt;
+    double libc;
+} Row;
+
+static void row(const Row *r) {
+    printf("%-11s %10.1f %10.1f %7.2fx\n", r->name, r->fmt, r->libc, r->libc / r->fmt);
+}
+
+int main(void) {
+    char out[48];
+    uint64_t start;
+    Row r;
+
+    srand(1);
+    for (int i = 0; i < CALLS; i++) {
+        input[i] = (int32_t)(((uint32_t)rand() << 8) ^ (uint32_t)rand()) % (4096 * 65536);
+    }
+    printf("%-11s %10s %10s %8s\n", "formatter", "fmt c/call", "libc c/call", "speedup");
+
+    r.name = "fmt_centi";
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) bench_sink += fmt_centi(out, input[i] >> 8);
+    r.fmt = (double)(bench_cycles() - start) / CALLS;
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) {
+        int32_t v = input[i] >> 8;
+        uint32_t m = v < 0 ? 0U - (uint32_t)v : (uint32_t)v;
+        bench_sink += snprintf(out, sizeof(out), "%s%lu.%02lu", v < 0 ? "-" : "",
+                               (unsigned long)(m / 100), (unsigned long)(m % 100));
+    }
+    r.libc = (double)(bench_cycles() - start) / CALLS;
+    row(&r);
+
+    r.name = "fmt_q16";
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) bench_sink += fmt_q16(out, input[i]);
+    r.fmt = (double)(bench_cycles() - start) / CALLS;
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) bench_sink += snprintf(out, sizeof(out), "%.2f", input[i] / 65536.0);
+    r.libc = (double)(bench_cycles() - start) / CALLS;
+    row(&r);
+
+    r.name = "fmt_float";
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) bench_sink += fmt_float(out, input[i] / 65536.0f);
+    r.fmt = (double)(bench_cycles() - start) / CALLS;
+    start = bench_cycles();
+    for (int i = 0; i < CALLS; i++) bench_sink += snprintf(out, sizeof(out), "%.2f", (double)(input[i] / 65536.0f));
+    r.libc = (double)(bench_cycles() - start) / CALLS;
+    row(&r);
+    return EXIT_SUCCESS;
+}
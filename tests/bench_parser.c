@@ -0,0 +1,156 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+#include "parser.h"
+
+#define BENCH_BYTES (1UL << 20)
+#define BENCH_ROUNDS 5
+
+/* Recorded command session: a ground station script as seen on the link */
+static const char *const session[] = {
+    "$RATE,5*", "$MODE,1*", "$FILT,1,4*", "$STAT*", "$CAL,1*",
+    "$RATE,10*4A", "$PRF,16*", "$CAL,0*", "$MODE,0*", "$FILT,2,8*",
+};
+
+static uint8_t stream[BENCH_BYTES];
+
+static size_t fill_session(uint8_t *buf, size_t size) {
+    size_t n = 0;
+
+    for (unsigned k = 0; ; k++) {
+        const char *msg = session[k % (sizeof(session) / sizeof(session[0]))];
+        size_t len = strlen(msg);
+        if (n + len + 2 > size) {
+            return n;
+        }
+        memcpy(&buf[n], msg, len);
+        n += len;
+        buf[n++] = '\r';
+        buf[n++] = '\n';
+    }
+}
+
+/* Synthetic commands with 1-4 numeric fields and a valid checksum */
+static size_t fill_valid(uint8_t *buf, size_t size) {
+    static const char *const types[] = { "RATE", "MODE", "FILT", "CAL", "PRF" };
+    size_t n = 0;
+
+    for (;;) {
+        char msg[64];
+        int len = snprintf(msg, sizeof(msg), "$%s", types[rand() % 5]);
+        for (int f = rand() % 4; f >= 0; f--) {
+            len += snprintf(msg + len, sizeof(msg) - len, ",%d", rand() % 20001 - 10000);
+        }
+        unsigned char sum = 0;
+        for (int i = 1; i < len; i++) sum ^= (unsigned char)msg[i];
+        len += snprintf(msg + len, sizeof(msg) - len, "*%02X\r\n", sum);
+        if (n + len > size) return n;
+        memcpy(&buf[n], msg, len);
+        n += len;
+    }
+}
+
+/* Line noise: random bytes, stray '$', truncated messages and bad checksums */
+static size_t fill_malformed(uint8_t *buf, size_t size) {
+    size_t n = 0;
+
+    while (n + 16 <= size) {
+        switch (rand() % 4) {
+            case 0: n += snprintf((char *)&buf[n], 16, "$RATE,%d*00", rand() % 100); break;
+            case 1: n += snprintf((char *)&buf[n], 16, "$TOOLONGTYPE,"); break;
+            case 2: buf[n++] = '$'; break;
+            default:
+                for (int i = rand() % 16; i > 0; i--) buf[n++] = (uint8_t)(rand() % 256);
+                break;
+        }
+    }
+    return n;
+}
+
+/* Longest accepted messages: 5-char type, 99-byte payload of 8 fields, checksum */
+static size_t fill_maxlen(uint8_t *buf, size_t size) {
+    size_t n = 0;
+
+    for (;;) {
+        char msg[PARSER_PAYLOAD_SIZE + 16] = "$ABCDE,";
+        int len = 7;
+        for (int i = 0; len < 7 + PARSER_PAYLOAD_SIZE - 1; i++) {
+            msg[len++] = (i % 12 == 11 && i < 84) ? ',' : (char)('0' + i % 10);
+        }
+        unsigned char sum = 0;
+        for (int i = 1; i < len; i++) sum ^= (unsigned char)msg[i];
+        len += snprintf(msg + len, sizeof(msg) - len, "*%02X", sum);
+        if (n + len > size) return n;
+        memcpy(&buf[n], msg, len);
+        n += len;
+    }
+}
+
+static void count_message(parser_state *ps, int result, void *ctx) {
+    (*(uint32_t *)ctx)++;
+}
+
+typedef struct {
+    double cycles;    // Per byte, TSC
+    double ns;        // Per byte, wall clock
+    uint32_t messages;
+} Result;
+
+/* Best of BENCH_ROUNDS */
+static Result run(const uint8_t *data, size_t len, int bulk) {
+    Result best = { 1e30, 1e30, 0 };
+
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        parser_state ps = { .state = STATE_DOLLAR };
+        uint32_t count = 0;
+        uint64_t ns = bench_ns();
+        uint64_t start = bench_cycles();
+
+        if (bulk) {
+            parse_bytes(&ps, data, len, count_message, &count);
+        } else {
+            for (size_t i = 0; i < len; i++) {
+                if (parse_byte(&ps, (char)data[i]) != NO_MESSAGE) {
+                    count++;
+                }
+            }
+        }
+        double cycles = (double)(bench_cycles() - start) / len;
+        double elapsed = (double)(bench_ns() - ns) / len;
+        if (cycles < best.cycles) best.cycles = cycles;
+        if (elapsed < best.ns) best.ns = elapsed;
+        best.messages = count;
+        bench_sink += count;
+    }
+    return best;
+}
+
+int main(void) {
+    static const struct {
+        const char *name;
+        size_t (*fill)(uint8_t *buf, size_t size);
+    } streams[] = {
+        { "session",   fill_session },
+        { "valid",     fill_valid },
+        { "malformed", fill_malformed },
+        { "maxlen",    fill_maxlen },
+    };
+    int status = EXIT_SUCCESS;
+
+    srand(1);
+    printf("%-10s %9s %9s %9s %9s %8s\n", "stream", "byte c/B", "bulk c/B", "byte ns/B", "bulk ns/B", "speedup");
+    for (size_t k = 0; k < sizeof(streams) / sizeof(streams[0]); k++) {
+        size_t len = streams[k].fill(stream, sizeof(stream));
+        Result byte = run(stream, len, 0);
+        Result bulk = run(stream, len, 1);
+
+        printf("%-10s %9.2f %9.2f %9.3f %9.3f %7.2fx\n", streams[k].name,
+               byte.cycles, bulk.cycles, byte.ns, bulk.ns, byte.ns / bulk.ns);
+        if (byte.messages != bulk.messages) {
+            printf("%s: message count differs: %u vs %u\n", streams[k].name, byte.messages, bulk.messages);
+            status = EXIT_FAILURE;
+        }
+    }
+    return status;
+}
@@ -0,0 +1,233 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include "parser.h"
+
+/*
+ * Parser fuzz target. Every input is checked against two oracles:
+ *  - differential: parse_bytes over random chunk splits must produce the
+ *    same results, messages, fields and final state as parse_byte on
+ *    every byte
+ *  - numeric: parse_int32/parse_int16/parse_q16/extract_integer against
+ *    a 64-bit reference on the same span
+ * A mismatch aborts. Built with -DFUZZ_LIBFUZZER for libFuzzer, otherwise
+ * main() runs a seeded random driver (make check).
+ */
+#define FUZZ_MAX_INPUT 8192
+#define FUZZ_MAX_EVENTS (FUZZ_MAX_INPUT / 2 + 1)
+
+typedef struct {
+    int result;
+    char type[PARSER_TYPE_SIZE];
+    char payload[PARSER_PAYLOAD_SIZE];
+    int fields;
+    unsigned char start[PARSER_MAX_FIELDS];
+    unsigned char len[PARSER_MAX_FIELDS];
+} Event;
+
+typedef struct {
+    Event event[FUZZ_MAX_EVENTS];
+    int count;
+} Trace;
+
+static Trace by_byte, by_block;
+
+static void fail(const char *what) {
+    fprintf(stderr, "fuzz_parser: %s\n", what);
+    abort();
+}
+
+static void record(Trace *t, const parser_state *ps, int result) {
+    Event *e;
+
+    if (t->count >= FUZZ_MAX_EVENTS) {
+        fail("event trace overflow");
+    }
+    e = &t->event[t->count++];
+    memset(e, 0, sizeof(*e));
+    e->result = result;
+    if (result != NEW_MESSAGE) {
+        return;   // Only a delivered message has defined contents
+    }
+    strcpy(e->type, ps->msg_type);
+    strcpy(e->payload, ps->msg_payload);
+    e->fields = ps->field_count;
+    for (int i = 0; i < ps->field_count && i < PARSER_MAX_FIELDS; i++) {
+        e->start[i] = ps->field_start[i];
+        e->len[i] = ps->field_len[i];
+    }
+}
+
+static void on_message(parser_state *ps, int result, void *ctx) {
+    record((Trace *)ctx, ps, result);
+}
+
+/* parse_byte on every byte vs parse_bytes on chunks of pseudo-random length */
+static void check_differential(const uint8_t *data, size_t size) {
+    parser_state a = { .state = STATE_DOLLAR };
+    parser_state b = { .state = STATE_DOLLAR };
+    uint32_t seed = (uint32_t)size * 2654435761u;
+    int result;
+
+    by_byte.count = 0;
+    by_block.count = 0;
+    for (size_t i = 0; i < size; i++) {
+        result = parse_byte(&a, (char)data[i]);
+        if (result != NO_MESSAGE) {
+            record(&by_byte, &a, result);
+        }
+    }
+    for (size_t i = 0; i < size; ) {
+        seed = seed * 1103515245u + 12345u;
+        size_t n = 1 + (seed >> 16) % 130;
+        if (n > size - i) n = size - i;
+        parse_bytes(&b, &data[i], n, on_message, &by_block);
+        i += n;
+    }
+    if ((result = parse_flush(&a)) != NO_MESSAGE) record(&by_byte, &a, result);
+    if ((result = parse_flush(&b)) != NO_MESSAGE) record(&by_block, &b, result);
+
+    if (by_byte.count != by_block.count) {
+        fail("message count differs");
+    }
+    if (memcmp(by_byte.event, by_block.event, by_byte.count * sizeof(Event)) != 0) {
+        fail("message contents differ");
+    }
+    if (a.state != b.state || a.errors != b.errors || a.index_type != b.index_type ||
+        a.index_payload != b.index_payload || a.checksum != b.checksum) {
+        fail("final state differs");
+    }
+}
+
+/* Reference integer parser: first error from left to right, like the firmware */
+static int ref_int(const char *s, int len, long long min, long long max, long long *out) {
+    int i = 0;
+    int negative = 0;
+    long long limit, value = 0;
+
+    if (len > 0 && (s[0] == '-' || s[0] == '+')) {
+        negative = (s[0] == '-');
+        i = 1;
+    }
+    if (i >= len) return NUM_ERR_EMPTY;
+    limit = negative ? 2147483648LL : 2147483647LL;
+    for (; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return NUM_ERR_SYNTAX;
+        value = value * 10 + (s[i] - '0');
+        if (value > limit) return NUM_ERR_RANGE;
+    }
+    value = negative ? -value : value;
+    if (value < min || value > max) return NUM_ERR_RANGE;
+    *out = value;
+    return NUM_OK;
+}
+
+/* Reference decimal syntax: [sign] digits [. digits], at least one digit */
+static int ref_decimal(const char *s, int len, long double *out) {
+    char buf[64];
+    int i = 0, digits = 0, dots = 0;
+
+    if (len > 0 && (s[0] == '-' || s[0] == '+')) i = 1;
+    for (; i < len; i++) {
+        if (s[i] == '.') dots++;
+        else if (s[i] >= '0' && s[i] <= '9') digits++;
+        else return 0;
+    }
+    if (dots > 1 || digits == 0 || len >= (int)sizeof(buf)) return 0;
+    memcpy(buf, s, len);
+    buf[len] = '\0';
+    *out = strtold(buf, NULL);
+    return 1;
+}
+
+static void check_numbers(const uint8_t *data, size_t size) {
+    char str[40];
+    int len = size < 32 ? (int)size : 32;
+    long long expect = 0;
+    int32_t v32 = 0x5A5A5A5A;
+    int16_t v16 = 0x5A5A;
+    int vint = 0x5A5A;
+    long double dec;
+
+    memcpy(str, data, len);
+    str[len] = '\0';
+
+    int ref = ref_int(str, len, INT32_MIN, INT32_MAX, &expect);
+    int got = parse_int32(str, len, INT32_MIN, INT32_MAX, &v32);
+    if (got != ref || (ref == NUM_OK && v32 != expect) || (ref != NUM_OK && v32 != 0x5A5A5A5A)) {
+        fail("parse_int32 differs from the reference");
+    }
+
+    ref = ref_int(str, len, -1000, 1000, &expect);
+    got = parse_int16(str, len, -1000, 1000, &v16);
+    if (got != ref || (ref == NUM_OK && v16 != expect) || (ref != NUM_OK && v16 != 0x5A5A)) {
+        fail("parse_int16 differs from the reference");
+    }
+
+    // extract_integer stops at ',' or the terminator, everything before must be the number
+    int span = (int)strcspn(str, ",");
+    ref = ref_int(str, span, INT_MIN, INT_MAX, &expect);
+    got = extract_integer(str, &vint);
+    if (got != ref || (ref == NUM_OK && vint != expect)) {
+        fail("extract_integer differs from the reference");
+    }
+
+    got = parse_q16(str, len, &v32);
+    if (!ref_decimal(str, len, &dec)) {
+        if (got == NUM_OK) fail("parse_q16 accepted a malformed number");
+    } else if (fabsl(dec) < 32767.99L) {
+        if (got != NUM_OK) fail("parse_q16 rejected a valid number");
+        if (fabsl((long double)v32 - dec * 65536.0L) > 1.0L) fail("parse_q16 off by more than 1 LSB");
+    } else if (fabsl(dec) > 32768.01L && got == NUM_OK) {
+        fail("parse_q16 accepted an out of range number");
+    }
+}
+
+int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+    if (size > FUZZ_MAX_INPUT) {
+        return 0;
+    }
+    check_differential(data, size);
+    check_numbers(data, size);
+    return 0;
+}
+
+#ifndef FUZZ_LIBFUZZER
+/* Inputs built from parser tokens, so messages and numbers are common */
+static size_t random_input(uint8_t *buf, size_t max) {
+    static const char *const tokens[] = {
+        "$", ",", "*", "-", "+", ".", "0", "1", "9", "42", "32767", "-32768",
+        "2147483647", "-2147483648", "99999999999", "RATE", "MODE", "FILT",
+        "TOOLONG", "*00", "*4A", "*G", "\r\n", "x", "\0",
+    };
+    size_t n = 0, count = rand() % 60;
+
+    for (size_t k = 0; k < count; k++) {
+        if (rand() % 8 == 0) {
+            // Raw byte or a long payload run
+            size_t run = (rand() % 4 == 0) ? rand() % 120 : 1;
+            uint8_t byte = (uint8_t)rand();
+            for (size_t i = 0; i < run && n < max; i++) buf[n++] = byte;
+        } else {
+            const char *t = tokens[rand() % (sizeof(tokens) / sizeof(tokens[0]))];
+            size_t len = (*t == '\0') ? 1 : strlen(t);
+            for (size_t i = 0; i < len && n < max; i++) buf[n++] = (uint8_t)t[i];
+        }
+    }
+    return n;
+}
+
+int main(int argc, char **argv) {
+    static uint8_t buf[FUZZ_MAX_INPUT];
+    long runs = (argc > 1) ? atol(argv[1]) : 200000;
+
+    srand(1);
+    for (long r = 0; r < runs; r++) {
+        LLVMFuzzerTestOneInput(buf, random_input(buf, sizeof(buf)));
+    }
+    printf("%s: ok (%ld inputs)\n", __FILE__, runs);
+    return EXIT_SUCCESS;
+}
+#endif
@@ -0,0 +1,27 @@
+/*
+ * File:   pipeline.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+#ifndef PIPELINE_H
+#define	PIPELINE_H
+
+#include <stdint.h>
+
+/*
+ * filter.c built twice, MAG_INTEGER_PIPELINE=1 (pipeline_run_int) and =0
+ * (pipeline_run_float), so both magnetometer pipelines run side by side.
+ * Each sample gives the filter output in sensor LSB and the text the
+ * $MAG frame would carry.
+ */
+typedef struct {
+    double value[3];
+    char text[3][16];
+} PipeOut;
+
+void pipeline_run_int(const int16_t (*raw)[3], int n, uint8_t type, uint8_t window, PipeOut *out);
+void pipeline_run_float(const int16_t (*raw)[3], int n, uint8_t type, uint8_t window, PipeOut *out);
+
+#endif	/* PIPELINE_H */
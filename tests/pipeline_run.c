@@ -0,0 +1,45 @@
+#define PIPE_CAT2(a, b) a##b
+#define PIPE_CAT(a, b)  PIPE_CAT2(a, b)
+#define PIPE(name)      PIPE_CAT(name, PIPE_SUFFIX)
+
+// One copy of the filter per pipeline
+#define filter_config PIPE(filter_config)
+#define filter_update PIPE(filter_update)
+#define filter_output PIPE(filter_output)
+#include "../filter.c"
+
+#include "format.h"
+#include "pipeline.h"
+
+static double to_double(mag_value_t v) {
+#if MAG_INTEGER_PIPELINE
+    return v / 65536.0;
+#else
+    return v;
+#endif
+}
+
+/* The formatter send_mag_data uses for this pipeline */
+static void to_text(char *out, mag_value_t v) {
+#if MAG_INTEGER_PIPELINE
+    fmt_q16(out, v);
+#else
+    fmt_float(out, v);
+#endif
+}
+
+void PIPE(pipeline_run)(const int16_t (*raw)[3], int n, uint8_t type, uint8_t window, PipeOut *out) {
+    MagFilter f;
+
+    filter_config(&f, type, window);
+    for (int k = 0; k < n; k++) {
+        MagRaw sample = { raw[k][0], raw[k][1], raw[k][2] };
+        filter_update(&f, sample);
+        MagData d = filter_output(&f);
+        mag_value_t v[3] = { d.x, d.y, d.z };
+        for (int i = 0; i < 3; i++) {
+            out[k].value[i] = to_double(v[i]);
+            to_text(out[k].text[i], v[i]);
+        }
+    }
+}
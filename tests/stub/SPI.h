@@ -0,0 +1,9 @@
+/*
+ * File:   SPI.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+// spi.c and init.c include "SPI.h", which only resolves on a case-insensitive file system
+#include "../../spi.h"
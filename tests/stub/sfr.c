@@ -0,0 +1,8 @@
+#define SFR_DEFINE
+#include "xc.h"
+
+/* Called by Idle(), NULL returns at once */
+void (*host_idle_hook)(void) = 0;
+
+/* Called by Nop(), lets a test move time on in polling loops */
+void (*host_nop_hook)(void) = 0;
@@ -0,0 +1,57 @@
+/*
+ * File:   sim.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+#ifndef SIM_H
+#define	SIM_H
+
+#include "../../uart.h"
+#include "../../spi.h"
+
+/* Interrupt handlers, called by the simulators in place of the hardware */
+void _DMA0Interrupt(void);
+void _U1TXInterrupt(void);
+void _SPI1Interrupt(void);
+void _T1Interrupt(void);
+
+/*
+ * UART1 transmitter: runs the armed DMA0 blocks (or the byte-wise TX
+ * interrupt) until the ring is empty or max bytes are on the wire.
+ * Returns the bytes moved, uart_sim_errors counts DMA setups that did
+ * not point at the tail of the ring.
+ */
+uint16_t uart_sim_drain(uint8_t *wire, uint16_t max);
+extern uint16_t uart_sim_errors;
+
+/*
+ * SPI1: every byte written to SPI1BUF is shifted at once and its reply
+ * lands in the 8-deep RX FIFO (SRXMPT follows it). The reply is
+ * spi_sim_miso(mosi), or the byte's position in the log when NULL.
+ * Each byte is logged with the chip selects active while it was
+ * shifted. Shifting into a full RX FIFO sets SPIROV and counts in
+ * spi_sim_errors, as does reading an empty one.
+ */
+#define SPI_SIM_LOG  1024
+#define SPI_SIM_MAG  0x01          // Chip select bits in spi_sim_log_cs
+#define SPI_SIM_ACC  0x02
+#define SPI_SIM_GYR  0x04
+
+extern uint8_t spi_sim_log_mosi[SPI_SIM_LOG];
+extern uint8_t spi_sim_log_cs[SPI_SIM_LOG];
+extern uint16_t spi_sim_log_len;
+extern uint16_t spi_sim_errors;
+extern uint8_t (*spi_sim_miso)(uint8_t mosi);
+
+void spi_sim_reset(void);          // Empty FIFOs and log, release every CS
+void spi_sim_stale(uint8_t count); // Leave count unread bytes in the RX FIFO
+
+/*
+ * Raise the SPI1 interrupt while it is enabled, as the hardware does once
+ * the TX FIFO has drained. Returns the interrupts taken.
+ */
+uint16_t spi_sim_run(void);
+
+#endif	/* SIM_H */
@@ -0,0 +1,82 @@
+#include "sim.h"
+
+uint8_t spi_sim_log_mosi[SPI_SIM_LOG];
+uint8_t spi_sim_log_cs[SPI_SIM_LOG];
+uint16_t spi_sim_log_len = 0;
+uint16_t spi_sim_errors = 0;
+uint8_t (*spi_sim_miso)(uint8_t mosi) = 0;
+
+static uint8_t rx_fifo[SPI_FIFO_DEPTH];
+static uint8_t rx_head = 0, rx_tail = 0;
+static uint16_t shifted = 0;
+
+/* Chip selects driven low right now */
+static uint8_t selected(void) {
+    uint8_t cs = 0;
+
+    if (!(MAG_CS_LAT & MAG_CS_MASK)) cs |= SPI_SIM_MAG;
+    if (!(ACC_CS_LAT & ACC_CS_MASK)) cs |= SPI_SIM_ACC;
+    if (!(GYR_CS_LAT & GYR_CS_MASK)) cs |= SPI_SIM_GYR;
+    return cs;
+}
+
+static void rx_push(uint8_t byte) {
+    if ((uint8_t)(rx_head - rx_tail) == SPI_FIFO_DEPTH) {
+        SPI1STATbits.SPIROV = 1;   // Received byte lost
+        spi_sim_errors++;
+        return;
+    }
+    rx_fifo[rx_head++ % SPI_FIFO_DEPTH] = byte;
+    SPI1STATbits.SRXMPT = 0;
+}
+
+void spi_sim_reset(void) {
+    rx_head = rx_tail = 0;
+    shifted = 0;
+    spi_sim_log_len = 0;
+    spi_sim_errors = 0;
+    spi_sim_miso = 0;
+    SPI1STATbits.SRXMPT = 1;
+    SPI1STATbits.SPITBF = 0;
+    SPI1STATbits.SPIROV = 0;
+    MAG_CS_LAT |= MAG_CS_MASK;
+    ACC_CS_LAT |= ACC_CS_MASK;
+    GYR_CS_LAT |= GYR_CS_MASK;
+}
+
+void spi_sim_stale(uint8_t count) {
+    while (count-- > 0) {
+        rx_push(0xEE);
+    }
+}
+
+void spi_sim_put(uint8_t byte) {
+    if (spi_sim_log_len < SPI_SIM_LOG) {
+        spi_sim_log_mosi[spi_sim_log_len] = byte;
+        spi_sim_log_cs[spi_sim_log_len] = selected();
+        spi_sim_log_len++;
+    }
+    rx_push(spi_sim_miso ? spi_sim_miso(byte) : (uint8_t)shifted);
+    shifted++;
+}
+
+uint8_t spi_sim_get(void) {
+    if (rx_head == rx_tail) {
+        spi_sim_errors++;
+        return 0;
+    }
+    uint8_t byte = rx_fifo[rx_tail++ % SPI_FIFO_DEPTH];
+    SPI1STATbits.SRXMPT = (rx_head == rx_tail);
+    return byte;
+}
+
+uint16_t spi_sim_run(void) {
+    uint16_t taken = 0;
+
+    while (IEC0bits.SPI1IE && taken < 0xFFFF) {
+        IFS0bits.SPI1IF = 1;
+        _SPI1Interrupt();
+        taken++;
+    }
+    return taken;
+}
@@ -0,0 +1,48 @@
+#include "sim.h"
+
+uint16_t uart_sim_errors = 0;
+
+#if UART1_TX_USE_DMA
+/* One-shot block: DMA0CNT + 1 bytes from DMA0STAL, then CHEN clears and DMA0IF is raised */
+uint16_t uart_sim_drain(uint8_t *wire, uint16_t max) {
+    uint16_t total = 0;
+
+    while (DMA0CONbits.CHEN) {
+        uint16_t len = DMA0CNT + 1;
+        uint16_t idx = (uint16_t)(DMA0STAL - (uint16_t)(uintptr_t)uart1_tx.buffer);
+
+        if (idx != (uart1_tx.tail & UART_TX_BUF_MASK) || idx + len > UART_TX_BUF_SIZE ||
+            len != uart1_tx.dma_len) {
+            uart_sim_errors++;
+            break;
+        }
+        if (total + len > max) {
+            break;
+        }
+        memcpy(&wire[total], (const uint8_t *)&uart1_tx.buffer[idx], len);
+        total += len;
+
+        DMA0CONbits.CHEN = 0;
+        DMA0REQbits.FORCE = 0;
+        IFS0bits.DMA0IF = 1;
+        if (IEC0bits.DMA0IE) {
+            _DMA0Interrupt();
+        }
+    }
+    return total;
+}
+#else
+/* Every TX interrupt finds the FIFO empty */
+uint16_t uart_sim_drain(uint8_t *wire, uint16_t max) {
+    uint16_t total = 0;
+
+    while (IEC0bits.U1TXIE && total < max) {
+        uint16_t before = uart1_tx.tail;
+        _U1TXInterrupt();
+        while (before != uart1_tx.tail && total < max) {
+            wire[total++] = uart1_tx.buffer[before++ & UART_TX_BUF_MASK];
+        }
+    }
+    return total;
+}
+#endif
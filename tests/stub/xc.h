@@ -0,0 +1,84 @@
+/*
+ * File:   xc.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+/*
+ * Host stand-in for the XC16 device header: every SFR the firmware touches
+ * is a plain variable (defined once in sfr.c), bit fields keep their names
+ * but not their addresses. SPI1BUF accesses are routed to the SPI simulator
+ * through the SPI1_PUT/SPI1_GET hooks of spi.c. Idle() and Nop() call the
+ * host_idle_hook / host_nop_hook so a test can advance simulated time while
+ * tmr_tick_wait() sleeps or a polling loop spins.
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#include <stdint.h>
+
+#ifdef SFR_DEFINE
+#define SFR volatile
+#else
+#define SFR extern volatile
+#endif
+#define B unsigned
+
+SFR uint16_t ANSELA, ANSELB, ANSELC, ANSELD, ANSELE, ANSELG;
+SFR uint16_t U1BRG, U1TXREG, U1RXREG, SPI1BUF;
+SFR uint16_t TMR1, PR1, TMR2, PR2, TMR3, PR3, TMR4, PR4, TMR5, PR5, TMR3HLD, TMR5HLD;
+SFR uint16_t DMA0STAL, DMA0STAH, DMA0CNT, DMA0PAD, DMA0REQ, DMA1STAL, DMA1STAH, DMA1CNT, DMA1PAD, DMA1REQ;
+SFR uint16_t LATA, LATB, LATD, LATG;
+SFR struct { B LATA0:1, LATA1:1; } LATAbits;
+SFR struct { B LATB0:1, LATB1:1, LATB2:1, LATB3:1, LATB4:1; } LATBbits;
+SFR struct { B LATD0:1, LATD6:1, LATD7:1; } LATDbits;
+SFR struct { B LATG9:1; } LATGbits;
+SFR struct { B RE8:1, RE9:1; } PORTEbits;
+SFR struct { B TRISA0:1, TRISA1:1; } TRISAbits;
+SFR struct { B TRISB3:1, TRISB4:1; } TRISBbits;
+SFR struct { B TRISD0:1, TRISD6:1, TRISD11:1, TRISD7:1; } TRISDbits;
+SFR struct { B TRISE6:1, TRISE8:1, TRISE9:1; } TRISEbits;
+SFR struct { B TRISF12:1, TRISF13:1; } TRISFbits;
+SFR struct { B TRISG9:1; } TRISGbits;
+SFR struct { B RP64R:6; } RPOR0bits;
+SFR struct { B RP108R:6; } RPOR11bits;
+SFR struct { B RP109R:6; } RPOR12bits;
+SFR struct { B U1RXR:7; } RPINR18bits;
+SFR struct { B INT1R:7; } RPINR0bits;
+SFR struct { B INT2R:7, INT3R:7; } RPINR1bits;
+SFR struct { B SDI1R:7; } RPINR20bits;
+SFR struct { B UARTEN:1, BRGH:1, PDSEL:2, STSEL:1; } U1MODEbits;
+SFR struct { B UTXEN:1, OERR:1, URXDA:1, UTXBF:1, TRMT:1, URXISEL:2, UTXISEL0:1, UTXISEL1:1, FERR:1, PERR:1; } U1STAbits;
+SFR struct { B GIE:1, INT1EP:1, INT2EP:1, INT3EP:1; } INTCON2bits;
+SFR struct { B T1IF:1, T2IF:1, T3IF:1, U1TXIF:1, U1RXIF:1, DMA0IF:1, SPI1IF:1, SPI1EIF:1, INT0IF:1, DMA1IF:1; } IFS0bits;
+SFR struct { B T4IF:1, T5IF:1, INT1IF:1, INT2IF:1; } IFS1bits;
+SFR struct { B INT3IF:1; } IFS3bits;
+SFR struct { B T1IE:1, T2IE:1, T3IE:1, U1TXIE:1, U1RXIE:1, DMA0IE:1, SPI1IE:1, SPI1EIE:1, DMA1IE:1; } IEC0bits;
+SFR struct { B T4IE:1, T5IE:1, INT1IE:1, INT2IE:1; } IEC1bits;
+SFR struct { B INT3IE:1; } IEC3bits;
+SFR struct { B T1IP:3, U1TXIP:3, DMA0IP:3, SPI1IP:3, U1RXIP:3; } IPC0bits, IPC1bits, IPC2bits, IPC3bits;
+SFR struct { B INT3IP:3; } IPC13bits;
+SFR struct { B TON:1, TCKPS:2, T32:1, TCS:1, TGATE:1; } T1CONbits, T2CONbits, T3CONbits, T4CONbits, T5CONbits;
+SFR struct { B MSTEN:1, MODE16:1, CKP:1, CKE:1, PPRE:2, SPRE:3, SMP:1; } SPI1CON1bits;
+SFR struct { B SPIBEN:1; } SPI1CON2bits;
+SFR struct { B SPIEN:1, SPITBF:1, SPIRBF:1, SRXMPT:1, SISEL:3, SPIROV:1, SPIBEC:3, SRMPT:1; } SPI1STATbits;
+SFR struct { B CHEN:1, SIZE:1, DIR:1, HALF:1, NULLW:1, AMODE:2, MODE:2; } DMA0CONbits, DMA1CONbits;
+SFR struct { B IRQSEL:8, FORCE:1; } DMA0REQbits, DMA1REQbits;
+SFR struct { B DOZEN:1, DOZE:3, ROI:1; } CLKDIVbits;
+SFR struct { B IPL:3; } SRbits;
+
+// SPI1BUF writes and reads go through the SPI simulator (spi_sim.c)
+void spi_sim_put(uint8_t byte);
+uint8_t spi_sim_get(void);
+#define SPI1_PUT(b) spi_sim_put(b)
+#define SPI1_GET()  spi_sim_get()
+
+// Power saving and pipeline helpers
+extern void (*host_idle_hook)(void);
+extern void (*host_nop_hook)(void);
+#define Idle() do { if (host_idle_hook) host_idle_hook(); } while (0)
+#define Nop()  do { if (host_nop_hook) host_nop_hook(); } while (0)
+
+#endif	/* XC_H */
@@ -0,0 +1,29 @@
+/*
+ * File:   test.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+#ifndef TEST_H
+#define	TEST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Failed checks are printed and counted, TEST_EXIT() turns them into the exit status */
+static int test_failures = 0;
+
+#define CHECK(cond) do { \
+        if (!(cond)) { \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            test_failures++; \
+        } \
+    } while (0)
+
+#define TEST_EXIT() do { \
+        printf("%s: %s\n", __FILE__, test_failures ? "FAIL" : "ok"); \
+        return test_failures ? EXIT_FAILURE : EXIT_SUCCESS; \
+    } while (0)
+
+#endif	/* TEST_H */
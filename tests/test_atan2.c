@@ -0,0 +1,82 @@
+#include <math.h>
+#include "test.h"
+#include "bench.h"
+#include "spi.h"
+
+/*
+ * atan2_cdeg over the full circle at radii from a few counts to the
+ * int32 limit, against atan2() of the same integer inputs. Backs the
+ * spi.h claim: error <= 1 centi-degree everywhere. atan2f (the float
+ * pipeline) is measured on the same points for comparison.
+ */
+#define STEPS 360000   // 0.001 degree
+
+/* Angle difference in centi-degrees, wrapped to [-18000, 18000] */
+static double cdeg_error(double got, double want) {
+    double e = fmod(got - want, 36000.0);
+    if (e > 18000.0) e -= 36000.0;
+    if (e < -18000.0) e += 36000.0;
+    return fabs(e);
+}
+
+static double check_point(int32_t y, int32_t x, double *worst_f) {
+    double want = atan2((double)y, (double)x) * (18000.0 / M_PI);
+    double e = cdeg_error(atan2_cdeg(y, x), want);
+    double ef = cdeg_error(atan2f((float)y, (float)x) * (18000.0f / (float)M_PI), want);
+
+    if (ef > *worst_f) *worst_f = ef;
+    if (e > 1.0) {
+        fprintf(stderr, "atan2_cdeg(%ld, %ld) = %d, atan2 %.3f\n", (long)y, (long)x, atan2_cdeg(y, x), want);
+    }
+    return e;
+}
+
+int main(void) {
+    static const double radius[] = {
+        1, 2, 3, 7, 50, 1000, 4096, 32767,          // Raw sensor counts
+        65536, 4096.0 * 65536, 32767.0 * 65536,     // Q16.16 sensor LSB
+        1 << 29, 2147483647.0,
+    };
+    double worst = 0, worst_f = 0;
+
+    for (size_t r = 0; r < sizeof(radius) / sizeof(radius[0]); r++) {
+        double worst_r = 0;
+        for (int32_t s = 0; s < STEPS; s++) {
+            double a = s * (2.0 * M_PI / STEPS);
+            double x = llround(radius[r] * cos(a)), y = llround(radius[r] * sin(a));
+            if (x > INT32_MAX) x = INT32_MAX;
+            if (y > INT32_MAX) y = INT32_MAX;
+            if (x == 0 && y == 0) continue;
+            double e = check_point((int32_t)y, (int32_t)x, &worst_f);
+            if (e > worst_r) worst_r = e;
+        }
+        printf("radius %12.0f: worst %.3f cdeg\n", radius[r], worst_r);
+        if (worst_r > worst) worst = worst_r;
+    }
+
+    // Axes, diagonals and the int32 corners
+    static const int32_t corner[][2] = {
+        { 0, 1 }, { 1, 0 }, { 0, -1 }, { -1, 0 }, { 1, 1 }, { -1, -1 }, { 1, -1 }, { -1, 1 },
+        { INT32_MIN, 0 }, { 0, INT32_MIN }, { INT32_MIN, INT32_MIN }, { INT32_MAX, INT32_MIN },
+        { INT32_MIN, INT32_MAX }, { INT32_MAX, INT32_MAX }, { 0, INT32_MAX }, { INT32_MAX, 0 },
+        { -1, INT32_MIN }, { 1, INT32_MIN }, { -1, INT32_MAX }, { 1, INT32_MAX },
+    };
+    for (size_t c = 0; c < sizeof(corner) / sizeof(corner[0]); c++) {
+        double e = check_point(corner[c][0], corner[c][1], &worst_f);
+        if (e > worst) worst = e;
+    }
+    CHECK(atan2_cdeg(0, 0) == 0);
+    CHECK(worst <= 1.0);
+
+    // Cost per call on the host, both kernels on the same inputs
+    volatile int32_t vx = 123456, vy = -654321;
+    uint64_t start = bench_cycles();
+    for (int i = 0; i < 1000000; i++) bench_sink += atan2_cdeg(vy + i, vx);
+    double c_int = (bench_cycles() - start) / 1e6;
+    start = bench_cycles();
+    for (int i = 0; i < 1000000; i++) bench_sink += (int32_t)atan2f((float)(vy + i), (float)vx);
+    double c_float = (bench_cycles() - start) / 1e6;
+
+    printf("worst %.3f cdeg (atan2f %.3f cdeg), %.1f vs %.1f host cycles/call\n", worst, worst_f, c_int, c_float);
+    TEST_EXIT();
+}
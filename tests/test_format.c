@@ -0,0 +1,124 @@
+#include <math.h>
+#include "test.h"
+#include "format.h"
+
+/*
+ * Every formatter against snprintf("%.2f") on the exact value. The default
+ * run covers dense ranges around zero and a stride over the full input
+ * range; EXHAUSTIVE=1 in the environment walks every int32 / float bit
+ * pattern (minutes per formatter).
+ */
+static bool exhaustive;
+static uint32_t mismatches;
+
+static void compare(const char *what, const char *got, uint8_t len, double value, uint64_t input) {
+    char want[48];
+    int n = snprintf(want, sizeof(want), "%.2f", value);
+
+    if (len != n || strcmp(got, want) != 0) {
+        if (mismatches++ < 10) {
+            fprintf(stderr, "%s(0x%llx): \"%s\", snprintf \"%s\"\n", what, (unsigned long long)input, got, want);
+        }
+    }
+}
+
+static void centi(int32_t v) {
+    char out[FMT_FIXED2_MAX];
+    uint8_t len = fmt_centi(out, v);
+    char want[FMT_FIXED2_MAX + 2];
+
+    // Hundredths are exact as integers, build the reference without a double
+    snprintf(want, sizeof(want), "%s%lu.%02lu", v < 0 ? "-" : "",
+             (unsigned long)((v < 0 ? 0U - (uint32_t)v : (uint32_t)v) / 100),
+             (unsigned long)((v < 0 ? 0U - (uint32_t)v : (uint32_t)v) % 100));
+    if (len != strlen(want) || strcmp(out, want) != 0) {
+        if (mismatches++ < 10) fprintf(stderr, "fmt_centi(%ld): \"%s\", want \"%s\"\n", (long)v, out, want);
+    }
+}
+
+static void q16(int32_t v) {
+    char out[FMT_FIXED2_MAX];
+    uint8_t len = fmt_q16(out, v);
+    compare("fmt_q16", out, len, v / 65536.0, (uint32_t)v);
+}
+
+static void flt(uint32_t bits) {
+    union { uint32_t u; float f; } in = { .u = bits };
+    char out[FMT_FIXED2_MAX];
+    uint8_t len = fmt_float(out, in.f);
+
+    if (!isfinite(in.f) || fabs((double)in.f) * 100.0 >= 4294967296.0) {
+        if (len != 0 && mismatches++ < 10) {
+            fprintf(stderr, "fmt_float(0x%08lx): \"%s\", want 0\n", (unsigned long)bits, out);
+        }
+        return;
+    }
+    compare("fmt_float", out, len, in.f, bits);
+}
+
+static void test_fixed2(void) {
+    char out[FMT_FIXED2_MAX];
+
+    CHECK(fmt_fixed2(out, false, 0) == 4 && strcmp(out, "0.00") == 0);
+    CHECK(fmt_fixed2(out, true, 0) == 5 && strcmp(out, "-0.00") == 0);
+    CHECK(fmt_fixed2(out, true, UINT32_MAX) == 12 && strcmp(out, "-42949672.95") == 0);
+    CHECK(fmt_fixed2(out, false, 6553600) == 8 && strcmp(out, "65536.00") == 0);
+    CHECK(fmt_fixed2(out, false, 6553599) == 8 && strcmp(out, "65535.99") == 0);
+}
+
+static void test_centi(void) {
+    int64_t v;
+
+    mismatches = 0;
+    for (v = -2000000; v <= 2000000; v++) centi((int32_t)v);
+    for (v = INT32_MIN; v <= INT32_MAX; v += exhaustive ? 1 : 9973) centi((int32_t)v);
+    centi(INT32_MIN);
+    centi(INT32_MAX);
+    CHECK(mismatches == 0);
+}
+
+static void test_q16(void) {
+    int64_t v;
+
+    mismatches = 0;
+    for (v = -(1 << 21); v <= (1 << 21); v++) q16((int32_t)v);
+    for (v = INT32_MIN; v <= INT32_MAX; v += exhaustive ? 1 : 7919) q16((int32_t)v);
+    q16(INT32_MIN);
+    q16(INT32_MAX);
+    // Exact ties (x.xx5) round half to even like printf
+    for (v = 0; v < 65536 * 4; v += 16384) q16((int32_t)v), q16((int32_t)-v);
+    CHECK(mismatches == 0);
+}
+
+static void test_float(void) {
+    uint64_t b;
+
+    mismatches = 0;
+    // Sensor range: every multiple of 1/256 in [-4096, 4096], and the
+    // 2^20 floats just below +-4096 where the fewest fraction bits are left
+    for (int32_t k = -4096 * 256; k <= 4096 * 256; k++) {
+        union { float f; uint32_t u; } in = { .f = k / 256.0f };
+        flt(in.u);
+    }
+    for (b = 0; b < (1u << 20); b++) {
+        flt(0x45800000u - (uint32_t)b);
+        flt(0xC5800000u - (uint32_t)b);
+    }
+    for (b = 0; b <= UINT32_MAX; b += exhaustive ? 1 : 4099) flt((uint32_t)b);
+    flt(0x7F800000u);   // Inf
+    flt(0x7FC00000u);   // NaN
+    flt(0x00000001u);   // Smallest subnormal
+    flt(0x80000000u);   // -0.0
+    CHECK(mismatches == 0);
+}
+
+int main(void) {
+    const char *env = getenv("EXHAUSTIVE");
+    exhaustive = (env != NULL && env[0] == '1');
+
+    test_fixed2();
+    test_centi();
+    test_q16();
+    test_float();
+    TEST_EXIT();
+}
@@ -0,0 +1,113 @@
+#include <string.h>
+#include "test.h"
+#include "parser.h"
+
+/* Status and value of parse_int32 over a whole string */
+static int i32(const char *s, int32_t *out) {
+    *out = 0x12345678;
+    return parse_int32(s, (int)strlen(s), INT32_MIN, INT32_MAX, out);
+}
+
+static int i16(const char *s, int16_t *out) {
+    *out = 0x1234;
+    return parse_int16(s, (int)strlen(s), INT16_MIN, INT16_MAX, out);
+}
+
+static int q16(const char *s, int32_t *out) {
+    *out = 0x12345678;
+    return parse_q16(s, (int)strlen(s), out);
+}
+
+static void test_int32(void) {
+    int32_t v;
+
+    CHECK(i32("2147483647", &v) == NUM_OK && v == INT32_MAX);
+    CHECK(i32("-2147483648", &v) == NUM_OK && v == INT32_MIN);
+    CHECK(i32("+2147483647", &v) == NUM_OK && v == INT32_MAX);
+    CHECK(i32("2147483648", &v) == NUM_ERR_RANGE && v == 0x12345678);
+    CHECK(i32("-2147483649", &v) == NUM_ERR_RANGE);
+    CHECK(i32("99999999999", &v) == NUM_ERR_RANGE);
+    CHECK(i32("00000000000000000042", &v) == NUM_OK && v == 42);
+    CHECK(i32("-0", &v) == NUM_OK && v == 0);
+    CHECK(i32("", &v) == NUM_ERR_EMPTY && v == 0x12345678);
+    CHECK(i32("-", &v) == NUM_ERR_EMPTY);
+    CHECK(i32("+", &v) == NUM_ERR_EMPTY);
+    CHECK(i32("12a", &v) == NUM_ERR_SYNTAX && v == 0x12345678);
+    CHECK(i32("12 ", &v) == NUM_ERR_SYNTAX);
+    CHECK(i32(" 12", &v) == NUM_ERR_SYNTAX);
+    CHECK(i32("1.5", &v) == NUM_ERR_SYNTAX);
+    CHECK(i32("--1", &v) == NUM_ERR_SYNTAX);
+    CHECK(i32("+-1", &v) == NUM_ERR_SYNTAX);
+    CHECK(i32("1-", &v) == NUM_ERR_SYNTAX);
+
+    // Range limits given by the caller
+    CHECK(parse_int32("10", 2, 0, 10, &v) == NUM_OK && v == 10);
+    CHECK(parse_int32("11", 2, 0, 10, &v) == NUM_ERR_RANGE);
+    CHECK(parse_int32("-1", 2, 0, 10, &v) == NUM_ERR_RANGE);
+
+    // The span length is honoured, nothing past it is read
+    CHECK(parse_int32("123,456", 3, INT32_MIN, INT32_MAX, &v) == NUM_OK && v == 123);
+    CHECK(parse_int32("123", 0, INT32_MIN, INT32_MAX, &v) == NUM_ERR_EMPTY);
+}
+
+static void test_int16(void) {
+    int16_t v;
+
+    CHECK(i16("32767", &v) == NUM_OK && v == INT16_MAX);
+    CHECK(i16("-32768", &v) == NUM_OK && v == INT16_MIN);
+    CHECK(i16("32768", &v) == NUM_ERR_RANGE && v == 0x1234);
+    CHECK(i16("-32769", &v) == NUM_ERR_RANGE);
+    CHECK(i16("65536", &v) == NUM_ERR_RANGE);    // Would wrap to 0 if truncated
+    CHECK(i16("4294967296", &v) == NUM_ERR_RANGE);
+    CHECK(i16("", &v) == NUM_ERR_EMPTY);
+    CHECK(i16("-", &v) == NUM_ERR_EMPTY);
+    CHECK(i16("7x", &v) == NUM_ERR_SYNTAX && v == 0x1234);
+    CHECK(parse_int16("5", 1, 1, 8, &v) == NUM_OK && v == 5);
+    CHECK(parse_int16("9", 1, 1, 8, &v) == NUM_ERR_RANGE);
+    CHECK(parse_int16("0", 1, 1, 8, &v) == NUM_ERR_RANGE);
+}
+
+static void test_q16(void) {
+    int32_t v;
+
+    CHECK(q16("1", &v) == NUM_OK && v == 0x10000);
+    CHECK(q16("-1.5", &v) == NUM_OK && v == -0x18000);
+    CHECK(q16("0.5", &v) == NUM_OK && v == 0x8000);
+    CHECK(q16(".5", &v) == NUM_OK && v == 0x8000);
+    CHECK(q16("5.", &v) == NUM_OK && v == 0x50000);
+    CHECK(q16("0.00001", &v) == NUM_OK && v == 1);          // 0.655 LSB rounds up
+    CHECK(q16("0.000007", &v) == NUM_OK && v == 0);         // 0.459 LSB rounds down
+    CHECK(q16("-32768", &v) == NUM_OK && v == INT32_MIN);
+    CHECK(q16("32767.99998", &v) == NUM_OK && v == INT32_MAX);
+    CHECK(q16("32767.999995", &v) == NUM_ERR_RANGE);        // Rounds to 32768.0
+    CHECK(q16("32768", &v) == NUM_ERR_RANGE && v == 0x12345678);
+    CHECK(q16("-32768.00001", &v) == NUM_ERR_RANGE);
+    CHECK(q16("100000", &v) == NUM_ERR_RANGE);
+    CHECK(q16("1.2345678901234567890", &v) == NUM_OK && v == 80909);
+    CHECK(q16("", &v) == NUM_ERR_EMPTY);
+    CHECK(q16("-", &v) == NUM_ERR_EMPTY);
+    CHECK(q16(".", &v) == NUM_ERR_EMPTY);
+    CHECK(q16("-.", &v) == NUM_ERR_EMPTY);
+    CHECK(q16("1.2.3", &v) == NUM_ERR_SYNTAX && v == 0x12345678);
+    CHECK(q16("1.5a", &v) == NUM_ERR_SYNTAX);
+    CHECK(q16("1a.5", &v) == NUM_ERR_SYNTAX);
+    CHECK(q16("1e3", &v) == NUM_ERR_SYNTAX);
+}
+
+static void test_extract_integer(void) {
+    int v = 7;
+
+    CHECK(extract_integer("12,34", &v) == NUM_OK && v == 12);
+    CHECK(extract_integer("-5", &v) == NUM_OK && v == -5);
+    CHECK(extract_integer("12a", &v) == NUM_ERR_SYNTAX && v == -5);
+    CHECK(extract_integer(",1", &v) == NUM_ERR_EMPTY);
+    CHECK(extract_integer("", &v) == NUM_ERR_EMPTY);
+}
+
+int main(void) {
+    test_int32();
+    test_int16();
+    test_q16();
+    test_extract_integer();
+    TEST_EXIT();
+}
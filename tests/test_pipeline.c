@@ -0,0 +1,156 @@
+#include <math.h>
+#include <stdlib.h>
+#include "test.h"
+#include "filter.h"
+#include "calib.h"
+#include "pipeline.h"
+
+/*
+ * The integer (Q16.16) magnetometer pipeline against the float one on
+ * the same raw samples, for every filter type and window: the outputs
+ * agree within one LSB of the coarser representation, the integer
+ * boxcar and median are within one Q16.16 LSB of the exact value, and
+ * the $MAG text differs by at most one hundredth (values next to a
+ * rounding boundary). The calibration turns a known min/max envelope
+ * into the expected Q2.14 offsets and scales.
+ */
+#define SAMPLES 20000
+#define Q16_LSB (1.0 / 65536.0)
+
+static int16_t raw[SAMPLES][3];
+static PipeOut out_int[SAMPLES], out_float[SAMPLES];
+
+/* Spacing of floats around v */
+static double float_ulp(double v) {
+    float f = (float)fabs(v);
+    return nextafterf(f, INFINITY) - f;
+}
+
+/* Exact boxcar/median output of the last n samples of one axis */
+static double exact(int k, int axis, uint8_t type, uint8_t n) {
+    int16_t win[FILTER_WINDOW_MAX];
+    int count = (k + 1 < n) ? k + 1 : n;
+    double sum = 0;
+
+    for (int j = 0; j < count; j++) {
+        win[j] = raw[k - j][axis];
+        sum += win[j];
+    }
+    if (type == FILTER_BOXCAR) {
+        return sum / (MAG_RAW_SCALE * count);
+    }
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && win[j - 1] > win[j]; j--) {
+            int16_t t = win[j]; win[j] = win[j - 1]; win[j - 1] = t;
+        }
+    }
+    double mid = (count & 1) ? win[count / 2] : (win[count / 2 - 1] + win[count / 2]) / 2.0;
+    return mid / MAG_RAW_SCALE;
+}
+
+static MagRaw mag(int16_t x, int16_t y, int16_t z) {
+    MagRaw r = { x, y, z };
+    return r;
+}
+
+/* Envelope x -1000..3000, y -2000..2000, z -500..1500: radii 2000, 2000, 1000 */
+static void test_calib(void) {
+    static const int16_t sweep[][3] = {
+        { 3000, 0, 500 }, { -1000, 0, 500 }, { 1000, 2000, 500 }, { 1000, -2000, 500 },
+        { 1000, 0, 1500 }, { 1000, 0, -500 }, { 1200, 300, 100 }, { 0, -1500, 900 }
+    };
+    MagCalib cal;
+    MagRaw out;
+
+    calib_reset(&cal);
+    CHECK(!calib_stop(&cal));                     // Not running
+    calib_start(&cal);
+    for (uint8_t k = 0; k < sizeof(sweep) / sizeof(sweep[0]); k++) {
+        calib_update(&cal, mag(sweep[k][0], sweep[k][1], sweep[k][2]));
+    }
+    CHECK(cal.samples == 8);
+    CHECK(calib_stop(&cal));
+    CHECK(!cal.running);
+
+    // Mean radius 1666: scale = 1666 / radius in Q2.14, rounded
+    CHECK(cal.offset[0] == 1000 && cal.offset[1] == 0 && cal.offset[2] == 500);
+    CHECK(cal.scale[0] == 13648 && cal.scale[1] == 13648 && cal.scale[2] == 27296);
+    out = calib_apply(&cal, mag(3000, 2000, 1500));
+    CHECK(out.x == 1666 && out.y == 1666 && out.z == 1666);
+    out = calib_apply(&cal, mag(-1000, -2000, -500));
+    CHECK(out.x == -1666 && out.y == -1666 && out.z == -1666);
+    out = calib_apply(&cal, mag(INT16_MIN, INT16_MAX, INT16_MAX));
+    CHECK(out.x == -28129 && out.y == 27295 && out.z == INT16_MAX);   // z saturates
+
+    // Too few samples to span CAL_MIN_SPAN: stop fails, the correction stays
+    calib_start(&cal);
+    calib_update(&cal, mag(100, 100, 100));
+    calib_update(&cal, mag(100 + CAL_MIN_SPAN, 100 + CAL_MIN_SPAN - 1, 100));
+    CHECK(!calib_stop(&cal));
+    CHECK(cal.offset[0] == 1000 && cal.scale[0] == 13648);
+
+    // z not swept: x/y updated, z keeps its correction; a small axis is capped at 2.0
+    calib_start(&cal);
+    calib_update(&cal, mag(-CAL_MIN_SPAN / 2, -4000, 0));
+    calib_update(&cal, mag(CAL_MIN_SPAN / 2, 4000, 0));
+    CHECK(calib_stop(&cal));
+    CHECK(cal.offset[0] == 0 && cal.offset[1] == 0);
+    CHECK(cal.scale[0] == CAL_SCALE_MAX);
+    CHECK(cal.scale[1] == (uint16_t)((((4000 + CAL_MIN_SPAN / 2) / 2) * CAL_SCALE_ONE + 2000) / 4000));
+    CHECK(cal.offset[2] == 500 && cal.scale[2] == 27296);
+
+    calib_reset(&cal);
+    out = calib_apply(&cal, mag(-123, 456, INT16_MIN));
+    CHECK(out.x == -123 && out.y == 456 && out.z == INT16_MIN);
+}
+
+int main(void) {
+    uint32_t text_diff = 0, checked = 0;
+    double worst = 0, worst_exact = 0;
+
+    test_calib();
+
+    srand(1);
+    for (int k = 0; k < SAMPLES; k++) {
+        for (int i = 0; i < 3; i++) {
+            // Sensor range with noise, full int16 range now and then
+            raw[k][i] = (rand() % 50 == 0) ? (int16_t)(rand() % 65536 - 32768)
+                                           : (int16_t)(rand() % 16001 - 8000);
+        }
+    }
+
+    for (uint8_t type = 0; type < FILTER_COUNT; type++) {
+        for (uint8_t window = 1; window <= FILTER_WINDOW_MAX; window++) {
+            pipeline_run_int(raw, SAMPLES, type, window, out_int);
+            pipeline_run_float(raw, SAMPLES, type, window, out_float);
+
+            for (int k = 0; k < SAMPLES; k++) {
+                for (int i = 0; i < 3; i++) {
+                    double a = out_int[k].value[i], b = out_float[k].value[i];
+                    double lsb = fmax(Q16_LSB, float_ulp(b));
+                    double diff = fabs(a - b) / lsb;
+                    if (diff > worst) worst = diff;
+                    if (diff > 1.0) {
+                        CHECK(diff <= 1.0);
+                        fprintf(stderr, "type %u window %u sample %d: %.9f vs %.9f\n", type, window, k, a, b);
+                        goto next;
+                    }
+                    if (type != FILTER_EMA) {
+                        double e = fabs(a - exact(k, i, type, window)) / Q16_LSB;
+                        if (e > worst_exact) worst_exact = e;
+                        CHECK(e <= 1.0);
+                    }
+                    if (strcmp(out_int[k].text[i], out_float[k].text[i]) != 0) {
+                        text_diff++;
+                        CHECK(fabs(atof(out_int[k].text[i]) - atof(out_float[k].text[i])) <= 0.0101);
+                    }
+                    checked++;
+                }
+            }
+        next:;
+        }
+    }
+    printf("%lu values: worst int/float gap %.3f LSB, worst int/exact %.3f Q16 LSB, %lu texts differ by 0.01\n",
+           (unsigned long)checked, worst, worst_exact, (unsigned long)text_diff);
+    TEST_EXIT();
+}
@@ -0,0 +1,117 @@
+#include <pthread.h>
+#include <sched.h>
+#include "test.h"
+#include "stub/sim.h"
+
+/*
+ * Producer and consumer on two threads, standing in for the ISR and the
+ * main loop. The rings rely on volatile ordering only, which holds on a
+ * TSO host (x86) as it does on the single-core dsPIC.
+ */
+#define STRESS_BYTES 4000000UL
+
+static volatile bool rx_fail = false;
+static volatile bool tx_fail = false;
+
+/* RX producer: the receive interrupt, one byte at a time */
+static void *rx_producer(void *arg) {
+    uint32_t n = 0;
+
+    while (n < STRESS_BYTES) {
+        if (UART1_RxBuffer_Write(&uart1_rx, (uint8_t)(n * 7 + 1))) {
+            n++;
+        } else {
+            sched_yield();
+        }
+    }
+    return NULL;
+}
+
+/* RX consumer: the main loop parsing in place with Peek/Consume */
+static void *rx_consumer(void *arg) {
+    UART_Span span[2];
+    uint32_t n = 0;
+
+    while (n < STRESS_BYTES && !rx_fail) {
+        uint8_t count = UART1_RxBuffer_Peek(&uart1_rx, span);
+        if (count == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            for (uint16_t j = 0; j < span[i].len; j++, n++) {
+                if (span[i].ptr[j] != (uint8_t)(n * 7 + 1)) {
+                    rx_fail = true;
+                }
+            }
+            UART1_RxBuffer_Consume(&uart1_rx, span[i].len);
+        }
+    }
+    return NULL;
+}
+
+/* TX producer: the main loop writing variable length blocks with Reserve/Commit */
+static void *tx_producer(void *arg) {
+    UART_Span span[2];
+    uint32_t n = 0;
+    uint16_t len = 1;
+
+    while (n < STRESS_BYTES) {
+        if (len > STRESS_BYTES - n) {
+            len = STRESS_BYTES - n;
+        }
+        uint8_t count = UART1_TxBuffer_Reserve(&uart1_tx, len, span);
+        if (count == 0) {
+            sched_yield();
+            continue;
+        }
+        for (uint8_t i = 0; i < count; i++) {
+            for (uint16_t j = 0; j < span[i].len; j++) {
+                span[i].ptr[j] = (uint8_t)((n++) * 13 + 5);
+            }
+        }
+        UART1_TxBuffer_Commit(&uart1_tx, len);
+        len = len % 37 + 1;
+    }
+    return NULL;
+}
+
+/* TX consumer: the byte-wise transmit interrupt */
+static void *tx_consumer(void *arg) {
+    uint32_t n = 0;
+    uint8_t data;
+
+    while (n < STRESS_BYTES && !tx_fail) {
+        if (!UART1_TxBuffer_Read(&uart1_tx, &data)) {
+            sched_yield();
+            continue;
+        }
+        if (data != (uint8_t)(n * 13 + 5)) {
+            tx_fail = true;
+        }
+        n++;
+    }
+    return NULL;
+}
+
+int main(void) {
+    pthread_t thread[4];
+
+    UART1_RxBuffer_Init(&uart1_rx);
+    UART1_TxBuffer_Init(&uart1_tx);
+
+    pthread_create(&thread[0], NULL, rx_producer, NULL);
+    pthread_create(&thread[1], NULL, rx_consumer, NULL);
+    pthread_create(&thread[2], NULL, tx_producer, NULL);
+    pthread_create(&thread[3], NULL, tx_consumer, NULL);
+    for (int i = 0; i < 4; i++) {
+        pthread_join(thread[i], NULL);
+    }
+
+    CHECK(!rx_fail);
+    CHECK(!tx_fail);
+    CHECK(UART1_RxBuffer_IsEmpty(&uart1_rx));
+    CHECK(UART1_TxBuffer_IsEmpty(&uart1_tx));
+    printf("rx ring found full %u times\n", uart1_rx.overflow);
+    TEST_EXIT();
+}
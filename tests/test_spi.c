@@ -0,0 +1,141 @@
+#include "test.h"
+#include "stub/sim.h"
+
+/*
+ * spi_transfer_start / _SPI1Interrupt state machine against the SPI
+ * simulator: bursts longer than the FIFO go out in FIFO-sized chunks, one
+ * interrupt each, and never overrun the RX FIFO.
+ */
+static uint16_t done_count;
+static uint8_t chain_rx[4];
+
+static void count_done(void) {
+    done_count++;
+}
+
+static void setup(void) {
+    spi_init();
+    spi_sim_reset();
+    done_count = 0;
+}
+
+/* 20 bytes: chunks of 8, 8 and 4, replies stored in order */
+static void test_chunks(void) {
+    uint8_t tx[20], rx[20];
+
+    setup();
+    for (uint8_t i = 0; i < sizeof(tx); i++) {
+        tx[i] = 0x40 + i;
+    }
+    CHECK(spi_transfer_start(tx, rx, sizeof(tx), count_done));
+    CHECK(spi_busy());
+    CHECK(IEC0bits.SPI1IE == 1);
+    CHECK(spi_sim_log_len == SPI_FIFO_DEPTH);   // First chunk only
+
+    CHECK(spi_sim_run() == 3);
+    CHECK(!spi_busy());
+    CHECK(IEC0bits.SPI1IE == 0);
+    CHECK(done_count == 1);
+    CHECK(spi_sim_log_len == sizeof(tx));
+    CHECK(memcmp(spi_sim_log_mosi, tx, sizeof(tx)) == 0);
+    for (uint8_t i = 0; i < sizeof(rx); i++) {
+        CHECK(rx[i] == i);
+    }
+    CHECK(spi_sim_errors == 0);
+    CHECK(SPI1STATbits.SPIROV == 0);
+}
+
+/* tx NULL clocks zeros, rx NULL discards the replies */
+static void test_null_buffers(void) {
+    uint8_t rx[12];
+
+    setup();
+    memset(rx, 0xAA, sizeof(rx));
+    CHECK(spi_transfer_start(NULL, rx, sizeof(rx), count_done));
+    CHECK(spi_sim_run() == 2);
+    for (uint8_t i = 0; i < sizeof(rx); i++) {
+        CHECK(spi_sim_log_mosi[i] == 0x00);
+        CHECK(rx[i] == i);
+    }
+
+    CHECK(spi_transfer_start(rx, NULL, sizeof(rx), NULL));   // No callback either
+    CHECK(spi_sim_run() == 2);
+    CHECK(spi_sim_log_len == 2 * sizeof(rx));
+    CHECK(done_count == 1);
+    CHECK(spi_sim_errors == 0);
+}
+
+/* A second start while busy and zero-length starts are refused */
+static void test_rejects(void) {
+    uint8_t tx[4] = { 1, 2, 3, 4 };
+
+    setup();
+    CHECK(!spi_transfer_start(tx, NULL, 0, count_done));
+    CHECK(!spi_busy());
+    CHECK(spi_transfer_start(tx, NULL, sizeof(tx), count_done));
+    CHECK(!spi_transfer_start(tx, NULL, sizeof(tx), count_done));
+    CHECK(spi_sim_run() == 1);
+    CHECK(done_count == 1);
+    CHECK(spi_sim_log_len == sizeof(tx));
+}
+
+/* Bytes left in the RX FIFO by a blocking transfer are dropped, not returned */
+static void test_stale_rx(void) {
+    uint8_t rx[4];
+
+    setup();
+    spi_sim_stale(3);
+    SPI1STATbits.SPIROV = 1;
+    CHECK(spi_transfer_start(NULL, rx, sizeof(rx), count_done));
+    CHECK(SPI1STATbits.SPIROV == 0);
+    CHECK(spi_sim_run() == 1);
+    for (uint8_t i = 0; i < sizeof(rx); i++) {
+        CHECK(rx[i] == i);
+    }
+    CHECK(spi_sim_errors == 0);
+}
+
+/* The next burst started from the callback runs from the same interrupt chain */
+static void chain_done(void) {
+    done_count++;
+    if (done_count == 1) {
+        CHECK(spi_transfer_start(NULL, chain_rx, sizeof(chain_rx), chain_done));
+    }
+}
+
+static void test_chain(void) {
+    uint8_t tx[10] = { 0 };
+
+    setup();
+    CHECK(spi_transfer_start(tx, NULL, sizeof(tx), chain_done));
+    CHECK(spi_sim_run() == 3);
+    CHECK(done_count == 2);
+    CHECK(chain_rx[0] == 10 && chain_rx[3] == 13);
+    CHECK(!spi_busy());
+}
+
+/* Blocking transfers keep the FIFO full without overrunning it */
+static void test_blocking(void) {
+    uint8_t tx[30], rx[30];
+
+    setup();
+    for (uint8_t i = 0; i < sizeof(tx); i++) {
+        tx[i] = i * 3;
+    }
+    spi_transfer(tx, rx, sizeof(tx));
+    CHECK(memcmp(spi_sim_log_mosi, tx, sizeof(tx)) == 0);
+    CHECK(rx[0] == 0 && rx[29] == 29);
+    CHECK(spi_write(0x5A) == 30);
+    CHECK(spi_sim_errors == 0);
+    CHECK(IEC0bits.SPI1IE == 0);
+}
+
+int main(void) {
+    test_chunks();
+    test_null_buffers();
+    test_rejects();
+    test_stale_rx();
+    test_chain();
+    test_blocking();
+    TEST_EXIT();
+}
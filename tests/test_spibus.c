@@ -0,0 +1,152 @@
+#include "test.h"
+#include "stub/sim.h"
+
+/*
+ * Bus manager on the SPI simulator: queued transactions are served by
+ * priority, oldest first within one, and ageing lets a low priority read
+ * through a saturating high priority load.
+ */
+#define ORDER_MAX 64
+
+static SpiTransaction *order[ORDER_MAX];
+static uint8_t order_len;
+
+static void record_done(SpiTransaction *t) {
+    if (order_len < ORDER_MAX) {
+        order[order_len++] = t;
+    }
+}
+
+static void setup(void) {
+    spi_init();
+    spi_sim_reset();
+    order_len = 0;
+}
+
+static void init_txn(SpiTransaction *t, const SpiDevice *dev, const uint8_t *tx, uint16_t len, uint8_t priority) {
+    memset(t, 0, sizeof(*t));
+    t->dev = dev;
+    t->tx = tx;
+    t->len = len;
+    t->priority = priority;
+    t->done = record_done;
+}
+
+/* Chip select the log shows for the first byte of each transaction (distinct tx[0]) */
+static uint8_t cs_of(uint8_t first) {
+    for (uint16_t i = 0; i < spi_sim_log_len; i++) {
+        if (spi_sim_log_mosi[i] == first) {
+            return spi_sim_log_cs[i];
+        }
+    }
+    return 0xFF;
+}
+
+/* The running transaction finishes, then high, normal (in submit order), low */
+static void test_priority_order(void) {
+    static const uint8_t tx_busy[10] = { 0x01 }, tx_low[3] = { 0x02 }, tx_norm1[3] = { 0x03 },
+                         tx_norm2[3] = { 0x04 }, tx_high[3] = { 0x05 };
+    SpiTransaction busy, low, norm1, norm2, high;
+
+    setup();
+    init_txn(&busy, &gyr_device, tx_busy, sizeof(tx_busy), SPIBUS_PRIO_LOW);
+    init_txn(&low, &gyr_device, tx_low, sizeof(tx_low), SPIBUS_PRIO_LOW);
+    init_txn(&norm1, &acc_device, tx_norm1, sizeof(tx_norm1), SPIBUS_PRIO_NORMAL);
+    init_txn(&norm2, &acc_device, tx_norm2, sizeof(tx_norm2), SPIBUS_PRIO_NORMAL);
+    init_txn(&high, &mag_device, tx_high, sizeof(tx_high), SPIBUS_PRIO_HIGH);
+
+    CHECK(spibus_submit(&busy));            // Bus free: starts at once
+    CHECK(!spibus_submit(&busy));           // Still pending
+    CHECK(spibus_submit(&low));
+    CHECK(spibus_submit(&norm1));
+    CHECK(spibus_submit(&norm2));
+    CHECK(spibus_submit(&high));
+    CHECK(!spibus_idle());
+
+    spi_sim_run();
+    CHECK(spibus_idle());
+    CHECK(order_len == 5);
+    CHECK(order[0] == &busy);
+    CHECK(order[1] == &high);
+    CHECK(order[2] == &norm1);
+    CHECK(order[3] == &norm2);
+    CHECK(order[4] == &low);
+    CHECK(spi_sim_log_len == 22);
+
+    // Every byte clocked with exactly its own device selected
+    CHECK(cs_of(0x01) == SPI_SIM_GYR);
+    CHECK(cs_of(0x05) == SPI_SIM_MAG);
+    CHECK(cs_of(0x03) == SPI_SIM_ACC);
+    CHECK(cs_of(0x02) == SPI_SIM_GYR);
+    CHECK((MAG_CS_LAT & MAG_CS_MASK) && (ACC_CS_LAT & ACC_CS_MASK) && (GYR_CS_LAT & GYR_CS_MASK));
+    CHECK(spi_sim_errors == 0);
+}
+
+/* A high priority read resubmitted from its own completion never leaves the bus free */
+static SpiTransaction flood, starved;
+static uint16_t flood_runs;
+
+static void flood_done(SpiTransaction *t) {
+    flood_runs++;
+    record_done(t);
+    if (starved.pending && flood_runs < 100) {
+        spibus_submit(&flood);
+    }
+}
+
+static void test_ageing(void) {
+    static const uint8_t tx_flood[9] = { 0x10 }, tx_starved[7] = { 0x20 };
+
+    setup();
+    init_txn(&flood, &mag_device, tx_flood, sizeof(tx_flood), SPIBUS_PRIO_HIGH);
+    flood.done = flood_done;
+    init_txn(&starved, &gyr_device, tx_starved, sizeof(tx_starved), SPIBUS_PRIO_LOW);
+    flood_runs = 0;
+    uint16_t promoted = spibus_stats.promoted;
+
+    CHECK(spibus_submit(&flood));
+    CHECK(spibus_submit(&starved));
+    spi_sim_run();
+
+    // Passed over once per flood completion until it ages to the front,
+    // the flood read queued by the last of those goes next
+    CHECK(!starved.pending);
+    CHECK(order_len == 3 + SPIBUS_MAX_WAITS);
+    CHECK(order[1 + SPIBUS_MAX_WAITS] == &starved);
+    CHECK(flood_runs == 2 + SPIBUS_MAX_WAITS);
+    CHECK(spibus_stats.promoted == promoted + 1);
+    CHECK(spibus_idle());
+    CHECK(spi_sim_errors == 0);
+}
+
+/* Devices with the same mode and clock share the configuration, others reapply it */
+static void test_configure(void) {
+    static const SpiDevice slow = { &ACC_CS_LAT, ACC_CS_MASK, 0, 0, 7 };
+    static const uint8_t tx[2];
+
+    setup();
+    spibus_select(&mag_device);
+    spibus_deselect(&mag_device);
+    SPI1CON1bits.PPRE = 3;           // Marker: only a reconfiguration overwrites it
+    spibus_select(&acc_device);      // Same settings as the magnetometer
+    spi_transfer(tx, NULL, sizeof(tx));
+    spibus_deselect(&acc_device);
+    CHECK(SPI1CON1bits.PPRE == 3);
+
+    spibus_select(&slow);
+    spibus_deselect(&slow);
+    CHECK(SPI1CON1bits.PPRE == 0 && SPI1CON1bits.SPRE == 7);
+    CHECK(SPI1CON1bits.CKP == 0 && SPI1CON1bits.CKE == 1);
+    spibus_select(&gyr_device);
+    spibus_deselect(&gyr_device);
+    CHECK(SPI1CON1bits.PPRE == IMU_SPI_PPRE && SPI1CON1bits.SPRE == IMU_SPI_SPRE);
+    CHECK(SPI1STATbits.SPIEN == 1);
+    CHECK(spi_sim_log_cs[0] == SPI_SIM_ACC);
+}
+
+int main(void) {
+    test_priority_order();
+    test_ageing();
+    test_configure();
+    TEST_EXIT();
+}
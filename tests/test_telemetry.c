@@ -0,0 +1,187 @@
+#include "test.h"
+#include "stub/sim.h"
+#include "telemetry.h"
+#include "tlm_decode.h"
+
+#define SAMPLES 2000
+
+static TlmDecoder dec;
+static int16_t sent[SAMPLES][3];
+
+/* Decoded events since the last pump */
+static struct {
+    uint16_t mags, yaws, texts, skips, bad;
+    int16_t mag[SAMPLES][3];
+    int16_t yaw[SAMPLES];
+    char text[4][TLM_DEC_MAX + 1];
+} got;
+
+static MagData mag_data(const int16_t axis[3]) {
+    MagData m;
+#if MAG_INTEGER_PIPELINE
+    m.x = (int32_t)axis[0] * 65536;
+    m.y = (int32_t)axis[1] * 65536;
+    m.z = (int32_t)axis[2] * 65536;
+#else
+    m.x = axis[0];
+    m.y = axis[1];
+    m.z = axis[2];
+#endif
+    return m;
+}
+
+/* Put everything queued on the wire and decode it */
+static uint16_t pump(void) {
+    static uint8_t wire[UART_TX_BUF_SIZE * 2];
+    uint16_t n = uart_sim_drain(wire, sizeof(wire));
+
+    for (uint16_t i = 0; i < n; i++) {
+        switch (tlm_decode_byte(&dec, wire[i])) {
+            case TLM_EV_MAG:
+                memcpy(got.mag[got.mags++], dec.mag, sizeof(dec.mag));
+                break;
+            case TLM_EV_YAW:
+                got.yaw[got.yaws++] = dec.yaw;
+                break;
+            case TLM_EV_TEXT:
+                if (got.texts < 4) strcpy(got.text[got.texts], dec.text);
+                got.texts++;
+                break;
+            case TLM_EV_SKIP:
+                got.skips++;
+                break;
+            case TLM_EV_BAD:
+                got.bad++;
+                break;
+            default:
+                break;
+        }
+    }
+    return n;
+}
+
+static void reset(uint8_t mode) {
+    UART1_Init(BAUDRATE);
+    memset(&mag_stream, 0, sizeof(mag_stream));
+    memset(&yaw_stream, 0, sizeof(yaw_stream));
+    mag_stream.policy = TX_DROP_OLDEST;
+    yaw_stream.policy = TX_DROP_OLDEST;
+    telemetry_set_mode(mode);
+    tlm_decode_init(&dec);
+    memset(&got, 0, sizeof(got));
+}
+
+/* Random walk with an occasional jump too large for a delta */
+static void make_samples(uint16_t count) {
+    int16_t axis[3] = { 0, 0, 0 };
+
+    for (uint16_t k = 0; k < count; k++) {
+        for (int i = 0; i < 3; i++) {
+            int step = (rand() % 64 == 0) ? rand() % 2001 - 1000 : rand() % 61 - 30;
+            int v = axis[i] + step;
+            axis[i] = (int16_t)(v > 4000 ? 4000 : v < -4000 ? -4000 : v);
+            sent[k][i] = axis[i];
+        }
+    }
+}
+
+/* Every sample arrives exactly, absolute and delta encoded */
+static void test_round_trip(uint8_t mode) {
+    reset(mode);
+    make_samples(SAMPLES);
+    for (uint16_t k = 0; k < SAMPLES; k++) {
+        MagData m = mag_data(sent[k]);
+        send_mag_data(&m);
+        send_yaw_data((int16_t)(k * 17 - 18000));
+        pump();
+    }
+    CHECK(got.mags == SAMPLES);
+    CHECK(got.yaws == SAMPLES);
+    CHECK(got.bad == 0 && got.skips == 0 && dec.gaps == 0);
+    CHECK(memcmp(got.mag, sent, sizeof(sent)) == 0);
+    for (uint16_t k = 0; k < SAMPLES; k++) {
+        if (got.yaw[k] != (int16_t)(k * 17 - 18000)) {
+            CHECK(got.yaw[k] == (int16_t)(k * 17 - 18000));
+            break;
+        }
+    }
+}
+
+/* Text replies in binary mode are delimited and do not disturb the frames */
+static void test_text_in_binary(void) {
+    int16_t axis[3] = { 100, -200, 300 };
+    MagData m = mag_data(axis);
+
+    reset(TLM_MODE_BINARY_DELTA);
+    send_mag_data(&m);
+    UART1_SendString("$ACK,MODE*");
+    axis[0] += 5;
+    m = mag_data(axis);
+    send_mag_data(&m);              // Delta across the text message
+    send_yaw_data(-4500);
+    pump();
+
+    CHECK(got.texts == 1 && strcmp(got.text[0], "$ACK,MODE*") == 0);
+    CHECK(got.mags == 2 && got.mag[1][0] == 105 && got.mag[1][1] == -200 && got.mag[1][2] == 300);
+    CHECK(got.yaws == 1 && got.yaw[0] == -4500);
+    CHECK(got.bad == 0);
+}
+
+/* ASCII mode keeps text messages byte-exact, no delimiter */
+static void test_text_in_ascii(void) {
+    uint8_t wire[32];
+
+    reset(TLM_MODE_ASCII);
+    UART1_SendString("$ERR,1*");
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == 7);
+    CHECK(memcmp(wire, "$ERR,1*", 7) == 0);
+}
+
+/*
+ * Congested link: frames are evicted or dropped, yet every decoded sample
+ * is one that was sent, in order, and a drop costs at most one skipped
+ * delta before the forced keyframe.
+ */
+static void test_congestion(void) {
+    uint16_t next = 0;
+    bool in_order = true;
+
+    reset(TLM_MODE_BINARY_DELTA);
+    make_samples(SAMPLES);
+    for (uint16_t k = 0; k < SAMPLES; k++) {
+        MagData m = mag_data(sent[k]);
+        send_mag_data(&m);
+        if (k % 3 == 0) {
+            send_yaw_data((int16_t)k);
+        }
+        if (k % 23 == 22) {
+            pump();
+        }
+    }
+    pump();
+
+    for (uint16_t i = 0; i < got.mags && in_order; i++) {
+        while (next < SAMPLES && memcmp(sent[next], got.mag[i], sizeof(sent[0])) != 0) {
+            next++;
+        }
+        in_order = (next < SAMPLES);
+        next++;
+    }
+    CHECK(in_order);
+    CHECK(mag_stream.frames_dropped > 0);
+    CHECK(got.mags > SAMPLES / 4);
+    CHECK(got.bad == 0);
+    CHECK(got.skips <= dec.gaps);
+    printf("congestion: %u of %u samples decoded, %u dropped, %lu gaps, %u deltas skipped\n",
+           got.mags, SAMPLES, mag_stream.frames_dropped, (unsigned long)dec.gaps, got.skips);
+}
+
+int main(void) {
+    srand(1);
+    test_round_trip(TLM_MODE_BINARY);
+    test_round_trip(TLM_MODE_BINARY_DELTA);
+    test_text_in_binary();
+    test_text_in_ascii();
+    test_congestion();
+    TEST_EXIT();
+}
@@ -0,0 +1,118 @@
+#include "test.h"
+#include "stub/sim.h"
+#include "health.h"
+
+/*
+ * tmr_tick_wait() against a simulated Timer4/5 cycle counter and Timer1
+ * tick: the main loop "works" by advancing the counter, Idle() jumps to
+ * the next tick. Checks miss counts, lateness, resynchronisation and the
+ * idle share, across a wrap of the 32-bit counter, and what health_tick()
+ * makes of them.
+ */
+#define TICK_CYCLES ((uint32_t)(TIMER1_PERIOD_MS * TMR_CYCLES_PER_MS))
+
+static uint32_t sim_now;
+static uint32_t sim_next_tick;
+
+static void sim_set(uint32_t now) {
+    sim_now = now;
+    TMR4 = (uint16_t)now;
+    TMR5HLD = (uint16_t)(now >> 16);
+}
+
+/* Let cycles pass, taking the tick interrupt at every period boundary */
+static void sim_advance(uint32_t cycles) {
+    while (cycles >= sim_next_tick - sim_now) {
+        cycles -= sim_next_tick - sim_now;
+        sim_set(sim_next_tick);
+        sim_next_tick += TICK_CYCLES;
+        if (IEC0bits.T1IE) {
+            IFS0bits.T1IF = 1;
+            _T1Interrupt();
+        }
+    }
+    sim_set(sim_now + cycles);
+}
+
+/* Idle() sleeps until the next interrupt, the tick */
+static void sim_idle(void) {
+    sim_advance(sim_next_tick - sim_now);
+}
+
+static void work_us(uint32_t us) {
+    sim_advance(us * TMR_CYCLES_PER_US);
+}
+
+int main(void) {
+    host_idle_hook = sim_idle;
+    sim_set(0xFFFFFFFFUL - 50 * TICK_CYCLES);   // Counter wraps 50 ticks in
+    sim_next_tick = sim_now + TICK_CYCLES;
+    tmr_tick_start(TIMER1_PERIOD_MS);
+    CHECK(IEC0bits.T1IE == 1);
+
+    // On time: 3 ms of work per 10 ms tick, every wait ends on a tick
+    uint8_t missed = 0;
+    CHECK(tmr_tick_wait() == 0);
+    tmr_idle_permille();
+    for (int i = 0; i < 100; i++) {
+        work_us(3000);
+        uint8_t ret = tmr_tick_wait();
+        health_tick(ret);
+        missed |= ret;
+        CHECK(sim_now == sim_next_tick - TICK_CYCLES);
+    }
+    CHECK(missed == 0);
+    CHECK(tmr_idle_permille() == 700);
+    CHECK(health.ticks == 100 && health.misses == 0);
+
+    // 25 ms of work: two ticks passed, the first of them 15 ms ago
+    work_us(25000);
+    uint8_t ret = tmr_tick_wait();
+    CHECK(ret == 2);
+    CHECK(tmr_tick_late() == 15000 * TMR_CYCLES_PER_US);
+    health_tick(ret);
+    CHECK(health.misses == 2);   // Both ticks, not one late wait
+    CHECK(health.overrun_run == 1);
+    CHECK(health.worst_late == 15000 * TMR_CYCLES_PER_US);
+
+    // Resynchronised on the latest tick: the next wait sleeps 5 ms, no catch-up
+    uint32_t before = sim_now;
+    CHECK(tmr_tick_wait() == 0);
+    CHECK(sim_now - before == 5000 * TMR_CYCLES_PER_US);
+
+    // Just over one period: one miss, late by the overshoot
+    work_us(10000 + 40);
+    CHECK(tmr_tick_wait() == 1);
+    CHECK(tmr_tick_late() == 40 * TMR_CYCLES_PER_US);
+    CHECK(tmr_tick_wait() == 0);
+
+    // Idle share over a mix of on-time and late ticks: 5 ms idle in 10
+    tmr_idle_permille();
+    work_us(5000);
+    CHECK(tmr_tick_wait() == 0);
+    CHECK(tmr_idle_permille() == 500);
+
+    // Miss counts saturate at 255
+    work_us(300 * TIMER1_PERIOD_MS * 1000UL);
+    CHECK(tmr_tick_wait() == 0xFF);
+
+    // Missed tick total saturates at UINT16_MAX
+    health.misses = UINT16_MAX - 10;
+    health_tick(0xFF);
+    CHECK(health.misses == UINT16_MAX);
+
+    // $STAT with every counter at its limit fills STAT_FRAME_MAX exactly
+    parser_state ps = { .errors = UINT16_MAX };
+    char stat[STAT_FRAME_MAX];
+    health.ticks = UINT32_MAX;
+    health.overrun_run_max = UINT16_MAX;
+    health.worst_late = UINT32_MAX;
+    uart1_rx.overflow = uart1_tx.overflow = uart1_rx.oerr = UINT16_MAX;
+    command_stats.rejected = UINT16_MAX;
+    mag_stats.queued = mag_stats.missed = mag_stats.duplicate = UINT16_MAX;
+    CHECK(health_format(&ps, stat, sizeof(stat)));
+    CHECK(strlen(stat) == STAT_FRAME_MAX - 1);
+
+    host_idle_hook = 0;
+    TEST_EXIT();
+}
@@ -0,0 +1,110 @@
+#include "test.h"
+#include "stub/sim.h"
+
+static UART_TxStream test_stream = { .policy = TX_DROP_NEWEST };
+
+/* Queue len bytes counting up from seed as one frame */
+static bool queue(uint8_t seed, uint16_t len) {
+    uint8_t data[UART_TX_BUF_SIZE];
+
+    for (uint16_t i = 0; i < len; i++) {
+        data[i] = (uint8_t)(seed + i);
+    }
+    return UART1_TxBuffer_WriteFrame(&uart1_tx, &test_stream, data, len);
+}
+
+static bool counts_up(const uint8_t *wire, uint8_t seed, uint16_t len) {
+    for (uint16_t i = 0; i < len; i++) {
+        if (wire[i] != (uint8_t)(seed + i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* A frame in the middle of the ring goes out as one block, one ISR entry */
+static void test_single_span(void) {
+    uint8_t wire[UART_TX_BUF_SIZE];
+
+    UART1_Init(BAUDRATE);
+    CHECK(queue(0x10, 40));
+    UART1_TxBuffer_Start(&uart1_tx);
+    CHECK(DMA0CONbits.CHEN == 1);
+    CHECK(DMA0CNT == 39);
+    CHECK(DMA0STAL == (uint16_t)(uintptr_t)&uart1_tx.buffer[0]);
+
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == 40);
+    CHECK(counts_up(wire, 0x10, 40));
+    CHECK(uart1_tx.isr_count == 1);
+    CHECK(uart1_tx.dma_len == 0);
+    CHECK(UART1_TxBuffer_IsEmpty(&uart1_tx));
+}
+
+/* A frame across the wrap point takes two chained blocks */
+static void test_wrap(void) {
+    uint8_t wire[UART_TX_BUF_SIZE];
+    const uint16_t offset = UART_TX_BUF_SIZE - 10;
+
+    UART1_Init(BAUDRATE);
+    CHECK(queue(0, offset));
+    UART1_TxBuffer_Start(&uart1_tx);
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == offset);
+
+    CHECK(queue(0x80, 30));
+    UART1_TxBuffer_Start(&uart1_tx);
+    CHECK(DMA0CNT == 9);   // Up to the end of storage first
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == 30);
+    CHECK(counts_up(wire, 0x80, 30));
+    CHECK(uart1_tx.isr_count == 3);
+    CHECK(uart_sim_errors == 0);
+}
+
+/* Frames queued while a block is on the wire are chained from the ISR */
+static void test_chaining(void) {
+    uint8_t wire[UART_TX_BUF_SIZE];
+
+    UART1_Init(BAUDRATE);
+    CHECK(queue(0x00, 20));
+    UART1_TxBuffer_Start(&uart1_tx);
+    CHECK(queue(20, 20));
+    UART1_TxBuffer_Start(&uart1_tx);   // Busy: must not re-arm the running block
+    CHECK(uart1_tx.dma_len == 20);
+    CHECK(DMA0CNT == 19);
+
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == 40);
+    CHECK(counts_up(wire, 0x00, 40));
+    CHECK(uart1_tx.isr_count == 2);
+}
+
+/* The first byte is only forced while the UART FIFO has room */
+static void test_force(void) {
+    uint8_t wire[UART_TX_BUF_SIZE];
+
+    UART1_Init(BAUDRATE);
+    U1STAbits.UTXBF = 0;
+    DMA0REQbits.FORCE = 0;
+    CHECK(queue(0, 8));
+    UART1_TxBuffer_Start(&uart1_tx);
+    CHECK(DMA0REQbits.FORCE == 1);
+
+    // Chained load with the FIFO still full from the previous block
+    CHECK(queue(8, 8));
+    U1STAbits.UTXBF = 1;
+    DMA0CONbits.CHEN = 0;
+    DMA0REQbits.FORCE = 0;
+    _DMA0Interrupt();
+    CHECK(DMA0CONbits.CHEN == 1);
+    CHECK(DMA0REQbits.FORCE == 0);   // The UART TX event requests the transfer
+
+    U1STAbits.UTXBF = 0;
+    CHECK(uart_sim_drain(wire, sizeof(wire)) == 8);
+    CHECK(counts_up(wire, 8, 8));
+}
+
+int main(void) {
+    test_single_span();
+    test_wrap();
+    test_chaining();
+    test_force();
+    TEST_EXIT();
+}
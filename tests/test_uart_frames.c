@@ -0,0 +1,187 @@
+#include "test.h"
+#include "stub/sim.h"
+
+static UART_TxStream other_stream = { .policy = TX_DROP_NEWEST };
+static UART_TxStream own_stream = { .policy = TX_DROP_OLDEST };
+
+/* Queue a frame of len bytes all set to tag */
+static bool queue(UART_TxStream *stream, uint8_t tag, uint16_t len) {
+    uint8_t data[UART_TX_BUF_SIZE];
+
+    memset(data, tag, len);
+    return UART1_TxBuffer_WriteFrame(&uart1_tx, stream, data, len);
+}
+
+/* Drain the ring and compare it with the expected tag/length runs */
+static bool wire_is(const uint8_t *tags, const uint16_t *lens, uint8_t runs) {
+    uint8_t wire[UART_TX_BUF_SIZE * 2];
+    uint16_t n, pos = 0;
+
+    UART1_TxBuffer_Start(&uart1_tx);
+    n = uart_sim_drain(wire, sizeof(wire));
+    for (uint8_t r = 0; r < runs; r++) {
+        for (uint16_t i = 0; i < lens[r]; i++, pos++) {
+            if (pos >= n || wire[pos] != tags[r]) {
+                return false;
+            }
+        }
+    }
+    return pos == n;
+}
+
+static void reset(void) {
+    UART1_Init(BAUDRATE);
+    memset(&other_stream, 0, sizeof(other_stream));
+    memset(&own_stream, 0, sizeof(own_stream));
+    other_stream.policy = TX_DROP_NEWEST;
+    own_stream.policy = TX_DROP_OLDEST;
+}
+
+/* Only the requesting stream's frames are evicted */
+static void test_drops_own_frame(void) {
+    reset();
+    CHECK(queue(&other_stream, 'A', 40));
+    CHECK(queue(&own_stream, 'm', 30));
+    CHECK(queue(&other_stream, 'B', 40));
+    CHECK(queue(&own_stream, 'M', 30));   // 18 free: m goes
+
+    static const uint8_t tags[] = { 'A', 'B', 'M' };
+    static const uint16_t lens[] = { 40, 40, 30 };
+    CHECK(wire_is(tags, lens, 3));
+    CHECK(own_stream.frames_dropped == 1 && own_stream.bytes_dropped == 30);
+    CHECK(other_stream.frames_dropped == 0);
+}
+
+/* No frame of the stream queued: the new frame is dropped, the others stay */
+static void test_no_own_frame(void) {
+    reset();
+    CHECK(queue(&other_stream, 'A', 60));
+    CHECK(queue(&other_stream, 'B', 60));
+    CHECK(!queue(&own_stream, 'M', 20));
+
+    static const uint8_t tags[] = { 'A', 'B' };
+    static const uint16_t lens[] = { 60, 60 };
+    CHECK(wire_is(tags, lens, 2));
+    CHECK(own_stream.frames_dropped == 1 && own_stream.bytes_dropped == 20);
+    CHECK(other_stream.frames_dropped == 0);
+}
+
+/* Own frames too small to make room: nothing is evicted, the newest is dropped */
+static void test_not_enough_room(void) {
+    reset();
+    CHECK(queue(&other_stream, 'A', 100));
+    CHECK(queue(&own_stream, 'm', 10));
+    CHECK(!queue(&own_stream, 'M', 40));   // 18 free + 10 droppable < 40
+
+    static const uint8_t tags[] = { 'A', 'm' };
+    static const uint16_t lens[] = { 100, 10 };
+    CHECK(wire_is(tags, lens, 2));
+    CHECK(own_stream.frames_dropped == 1 && own_stream.bytes_dropped == 40);
+    CHECK(own_stream.frames_sent == 1);
+}
+
+/* A frame handed to DMA is never evicted */
+static void test_started_frame_kept(void) {
+    reset();
+    CHECK(queue(&own_stream, 'm', 100));
+    UART1_TxBuffer_Start(&uart1_tx);      // Whole frame claimed by the DMA block
+    CHECK(!queue(&own_stream, 'M', 40));
+
+    static const uint8_t tags[] = { 'm' };
+    static const uint16_t lens[] = { 100 };
+    CHECK(wire_is(tags, lens, 1));
+    CHECK(own_stream.frames_dropped == 1);
+}
+
+/* Several old frames go when one is not enough */
+static void test_drops_several(void) {
+    reset();
+    CHECK(queue(&own_stream, 'a', 30));
+    CHECK(queue(&other_stream, 'X', 50));
+    CHECK(queue(&own_stream, 'b', 30));
+    CHECK(queue(&own_stream, 'M', 60));   // 18 free: a and b go
+
+    static const uint8_t tags[] = { 'X', 'M' };
+    static const uint16_t lens[] = { 50, 60 };
+    CHECK(wire_is(tags, lens, 2));
+    CHECK(own_stream.frames_dropped == 2 && own_stream.bytes_dropped == 60);
+    CHECK(uart_sim_errors == 0);
+}
+
+/* Simulated cycle counter, moved on by every Nop() of a polling loop */
+#define NOP_US 10
+static uint32_t sim_now;
+static uint32_t drain_at;          // Elapsed us at which the wire drains, 0 never
+static uint32_t wait_start;
+
+static void sim_set(uint32_t now) {
+    sim_now = now;
+    TMR4 = (uint16_t)now;
+    TMR5HLD = (uint16_t)(now >> 16);
+}
+
+static void sim_nop(void) {
+    uint8_t wire[UART_TX_BUF_SIZE];
+
+    sim_set(sim_now + NOP_US * TMR_CYCLES_PER_US);
+    if (drain_at != 0 && sim_now - wait_start >= drain_at * TMR_CYCLES_PER_US) {
+        uart_sim_drain(wire, sizeof(wire));
+        drain_at = 0;
+    }
+}
+
+/* Time a blocking write of len bytes into a ring held full by a started frame */
+static uint32_t blocked_write_us(UART_TxStream *stream, uint16_t len, bool *queued) {
+    reset();
+    CHECK(queue(&other_stream, 'A', 120));
+    UART1_TxBuffer_Start(&uart1_tx);
+    wait_start = sim_now;
+    *queued = queue(stream, 'R', len);
+    return (sim_now - wait_start) / TMR_CYCLES_PER_US;
+}
+
+/* TX_BLOCK waits for room, but never past timeout_ms or into the next tick's guard */
+static void test_block_limits(void) {
+    UART_TxStream reply = { .policy = TX_BLOCK, .timeout_ms = 20 };
+    bool queued;
+    uint32_t us;
+
+    host_nop_hook = sim_nop;
+    sim_set(0xFFFFFFFFUL - 5000 * TMR_CYCLES_PER_US);   // Wraps during the waits
+
+    // No tick yet (initialisation): the stream timeout is the limit
+    us = blocked_write_us(&reply, 40, &queued);
+    CHECK(!queued && reply.frames_dropped == 1);
+    CHECK(us >= 20000 && us <= 20000 + NOP_US);
+
+    // Room appears while waiting: the frame is queued at once
+    drain_at = 3000;
+    us = blocked_write_us(&reply, 40, &queued);
+    CHECK(queued);
+    CHECK(us >= 3000 && us <= 3000 + NOP_US);
+
+    // Tick running, 6 ms into a 10 ms period: gives up UART_TX_BLOCK_GUARD_US before it
+    tmr_tick_start(TIMER1_PERIOD_MS);
+    sim_set(sim_now + 6000 * TMR_CYCLES_PER_US);
+    us = blocked_write_us(&reply, 40, &queued);
+    CHECK(!queued);
+    CHECK(us + 6000 >= TIMER1_PERIOD_MS * 1000 - UART_TX_BLOCK_GUARD_US);
+    CHECK(us + 6000 <= TIMER1_PERIOD_MS * 1000 - UART_TX_BLOCK_GUARD_US + NOP_US);
+
+    // Tick already due: no wait at all
+    sim_set(sim_now + TIMER1_PERIOD_MS * 1000 * TMR_CYCLES_PER_US);
+    us = blocked_write_us(&reply, 40, &queued);
+    CHECK(!queued && us == 0);
+
+    host_nop_hook = 0;
+}
+
+int main(void) {
+    test_drops_own_frame();
+    test_no_own_frame();
+    test_not_enough_room();
+    test_started_frame_kept();
+    test_drops_several();
+    test_block_limits();
+    TEST_EXIT();
+}
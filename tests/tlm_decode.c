@@ -0,0 +1,96 @@
+#include <string.h>
+#include "tlm_decode.h"
+#include "telemetry.h"
+
+void tlm_decode_init(TlmDecoder *d) {
+    memset(d, 0, sizeof(*d));
+}
+
+/* COBS decode in place, returns the decoded length or -1 */
+static int cobs_decode(uint8_t *buf, uint16_t len) {
+    uint8_t out[TLM_DEC_MAX];
+    uint16_t i = 0, n = 0;
+
+    while (i < len) {
+        uint8_t code = buf[i++];
+        if (code == 0 || i + code - 1 > len) {
+            return -1;
+        }
+        for (uint8_t k = 1; k < code; k++) {
+            out[n++] = buf[i++];
+        }
+        if (code != 0xFF && i < len) {
+            out[n++] = 0;
+        }
+    }
+    memcpy(buf, out, n);
+    return n;
+}
+
+static int16_t le16(const uint8_t *p) {
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+/* One complete chunk (delimiter stripped) */
+static TlmEvent decode_chunk(TlmDecoder *d) {
+    uint8_t *p = d->chunk;
+    int n;
+
+    if (d->len > 0 && p[0] == '$') {
+        memcpy(d->text, p, d->len);
+        d->text[d->len] = '\0';
+        return TLM_EV_TEXT;
+    }
+    n = cobs_decode(p, d->len);
+    if (n < 4 || crc16_ccitt(p, n - 2) != (uint16_t)le16(&p[n - 2])) {
+        return TLM_EV_BAD;
+    }
+
+    // SEQ is shared by all binary frames: a gap may hide a MAG frame
+    if (d->have_seq && p[1] != (uint8_t)(d->seq + 1)) {
+        d->gaps++;
+        d->have_ref = false;
+    }
+    d->have_seq = true;
+    d->seq = p[1];
+
+    switch (p[0]) {
+        case TLM_TYPE_MAG:
+            if (n != 2 + 6 + 2) return TLM_EV_BAD;
+            for (int i = 0; i < 3; i++) {
+                d->ref[i] = d->mag[i] = le16(&p[2 + 2 * i]);
+            }
+            d->have_ref = true;
+            return TLM_EV_MAG;
+        case TLM_TYPE_MAG_DELTA:
+            if (n != 2 + 3 + 2) return TLM_EV_BAD;
+            if (!d->have_ref) return TLM_EV_SKIP;
+            for (int i = 0; i < 3; i++) {
+                d->ref[i] = d->mag[i] = (int16_t)(d->ref[i] + (int8_t)p[2 + i]);
+            }
+            return TLM_EV_MAG;
+        case TLM_TYPE_YAW:
+            if (n != 2 + 2 + 2) return TLM_EV_BAD;
+            d->yaw = le16(&p[2]);
+            return TLM_EV_YAW;
+        default:
+            return TLM_EV_BAD;
+    }
+}
+
+TlmEvent tlm_decode_byte(TlmDecoder *d, uint8_t byte) {
+    TlmEvent ev;
+
+    if (byte != 0x00) {
+        if (d->len < TLM_DEC_MAX) {
+            d->chunk[d->len++] = byte;
+        } else {
+            d->overlong = true;
+        }
+        return TLM_EV_NONE;
+    }
+    ev = d->overlong ? TLM_EV_BAD : decode_chunk(d);
+    d->len = 0;
+    d->overlong = false;
+    return ev;
+}
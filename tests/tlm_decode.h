@@ -0,0 +1,48 @@
+/*
+ * File:   tlm_decode.h
+ * Author: Rubin
+ *
+ * Created on October 18, 2026, 11:30 PM
+ */
+
+#ifndef TLM_DECODE_H
+#define	TLM_DECODE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * Receiver side of the binary telemetry (telemetry.h): splits the byte
+ * stream on 0x00, passes text messages through, COBS decodes and CRC
+ * checks the rest and rebuilds MAG samples from deltas. After a SEQ gap
+ * deltas are skipped until the next absolute MAG frame.
+ */
+typedef enum {
+    TLM_EV_NONE = 0,    // Frame not complete yet
+    TLM_EV_MAG,         // mag[] holds a sample (absolute or rebuilt from a delta)
+    TLM_EV_YAW,         // yaw holds an angle in centi-degrees
+    TLM_EV_TEXT,        // text holds a '$' message
+    TLM_EV_SKIP,        // Delta without a valid reference
+    TLM_EV_BAD          // COBS, CRC, type or length error
+} TlmEvent;
+
+#define TLM_DEC_MAX 64
+
+typedef struct {
+    uint8_t chunk[TLM_DEC_MAX];
+    uint16_t len;
+    bool overlong;
+    bool have_seq;
+    uint8_t seq;            // Last SEQ seen
+    bool have_ref;          // ref[] is what the sender holds
+    int16_t ref[3];
+    int16_t mag[3];
+    int16_t yaw;
+    char text[TLM_DEC_MAX + 1];
+    uint32_t gaps;          // SEQ gaps seen
+} TlmDecoder;
+
+void tlm_decode_init(TlmDecoder *d);
+TlmEvent tlm_decode_byte(TlmDecoder *d, uint8_t byte);
+
+#endif	/* TLM_DECODE_H */
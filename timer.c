@@ -186,4 +186,137 @@ void tmr_wait_ms(uint8_t timer, uint16_t ms) {
             // Handle invalid timer number
             break;
     }
-}
\ No newline at end of file
+}
+
+/* Function to start the free-running 32-bit cycle counter */
+void tmr_cycles_init(void) {
+    T4CONbits.TON = 0;  // Stop Timer 4/5
+    T5CONbits.TON = 0;
+    T4CONbits.T32 = 1;  // Timer 4/5 as one 32-bit timer
+    T4CONbits.TCKPS = 0;  // 1:1, counts instruction cycles
+    TMR5HLD = 0;        // MSW goes through the holding register
+    TMR4 = 0;
+    PR4 = 0xFFFF;       // Full 32-bit period
+    PR5 = 0xFFFF;
+    IFS1bits.T5IF = 0;
+    T4CONbits.TON = 1;  // Start counting
+}
+
+/* Function to read the cycle counter */
+uint32_t tmr_cycles(void) {
+    // Reading TMR4 latches TMR5 into TMR5HLD, no interrupt may read in between
+    bool gie = INTCON2bits.GIE;
+    INTCON2bits.GIE = 0;
+    uint16_t lsw = TMR4;
+    uint16_t msw = TMR5HLD;
+    INTCON2bits.GIE = gie;
+    
+    return ((uint32_t)msw << 16) | lsw;
+}
+
+/* Deadline us from now, for polling with tmr_expired() */
+uint32_t tmr_deadline_us(uint32_t us) {
+    return tmr_cycles() + us * TMR_CYCLES_PER_US;
+}
+
+/* True once the deadline has passed (valid for half the counter range) */
+bool tmr_expired(uint32_t deadline) {
+    return (int32_t)(tmr_cycles() - deadline) >= 0;
+}
+
+/* System tick state */
+static volatile uint16_t tick_count = 0;   // Raised by _T1Interrupt
+static uint16_t tick_seen = 0;             // Consumed by tmr_tick_wait
+static volatile uint32_t tick_stamp = 0;   // tmr_cycles() at the latest tick
+static uint32_t tick_period = 0;           // Tick length in cycles
+static uint32_t tick_late = 0;             // Lateness of the last missed tick
+static uint32_t idle_cycles = 0;           // Time spent waiting since the last report
+static uint32_t idle_since = 0;
+
+/* Function to start the Timer1 tick interrupt */
+void tmr_tick_start(uint16_t ms) {
+    tmr_setup_period(TIMER1, ms);
+    tick_period = (uint32_t)ms * TMR_CYCLES_PER_MS;
+    tick_seen = tick_count;
+    idle_cycles = 0;
+    idle_since = tmr_cycles();
+    tick_stamp = idle_since;  // The first period counts from here
+    IFS0bits.T1IF = 0;  // Clear the flag
+    IEC0bits.T1IE = 1;  // Enable Timer 1 interrupt
+}
+
+/* Timer1 interrupt: one tick elapsed */
+void __attribute__((interrupt, no_auto_psv)) _T1Interrupt(void) {
+    IFS0bits.T1IF = 0;  // Clear the interrupt flag
+    tick_stamp = tmr_cycles();
+    tick_count++;
+}
+
+/* Function to wait for the next tick in Idle */
+uint8_t tmr_tick_wait(void) {
+    // Tick count and stamp from the same interrupt
+    bool gie = INTCON2bits.GIE;
+    INTCON2bits.GIE = 0;
+    uint16_t late = tick_count - tick_seen;
+    uint32_t stamp = tick_stamp;
+    INTCON2bits.GIE = gie;
+    
+    if (late > 0) {
+        // Deadline missed: resynchronise on the latest tick instead of catching up
+        tick_late = (tmr_cycles() - stamp) + (uint32_t)(late - 1) * tick_period;
+        tick_seen += late;
+        return (late > 0xFF) ? 0xFF : (uint8_t)late;
+    }
+    
+    uint32_t start = tmr_cycles();
+    
+    // Masked interrupts still wake the CPU from Idle, so a tick arriving between
+    // the check and PWRSAV cannot be slept through; they are serviced in between
+    uint16_t ipl = SRbits.IPL;
+    SRbits.IPL = 7;
+    while (tick_count == tick_seen) {
+        Idle();
+        SRbits.IPL = ipl;   // Let the interrupt that woke us run
+        Nop();
+        SRbits.IPL = 7;
+    }
+    SRbits.IPL = ipl;
+    tick_seen++;
+    
+    idle_cycles += tmr_cycles() - start;  // Includes interrupts serviced while idle
+    return 0;
+}
+
+/* Function to report when the next tick is due, false before tmr_tick_start() */
+bool tmr_tick_next(uint32_t *due) {
+    if (tick_period == 0) {
+        return false;
+    }
+    *due = tick_stamp + tick_period;
+    return true;
+}
+
+/* Function to report how late the last missed tick was handled */
+uint32_t tmr_tick_late(void) {
+    return tick_late;
+}
+
+/* Function to report the idle share since the last call */
+uint16_t tmr_idle_permille(void) {
+    uint32_t now = tmr_cycles();
+    uint32_t idle = idle_cycles;
+    uint32_t elapsed = now - idle_since;
+    
+    idle_cycles = 0;
+    idle_since = now;
+    if (elapsed == 0) {
+        return 0;
+    }
+    // Scale both down so idle * 1000 fits in 32 bits
+    while (elapsed > 0x3FFFFFUL) {
+        elapsed >>= 1;
+        idle >>= 1;
+    }
+    uint32_t permille = idle * 1000 / elapsed;
+    return (permille > 1000) ? 1000 : (uint16_t)permille;
+}
@@ -28,6 +28,10 @@ extern "C" {
     
 /* Timer Constants */
 #define TIMER_MAX_COUNT 0xFFFF  // Maximum 16-bit timer value (65535)
+
+/* Cycle Counter (Timer4/5 in 32-bit mode, 1:1, wraps every ~59 s at FCY) */
+#define TMR_CYCLES_PER_MS (FCY / 1000)
+#define TMR_CYCLES_PER_US (FCY / 1000000)
     
 /* Prescaler Configuration */
 typedef struct {
@@ -45,6 +49,23 @@ typedef struct {
 void tmr_setup_period(uint8_t timer, uint16_t ms);
 uint8_t tmr_wait_period(uint8_t timer);
 void tmr_wait_ms(uint8_t timer, uint16_t ms);
+void tmr_cycles_init(void);   // Start the counter, Timer4/5 are reserved after this
+uint32_t tmr_cycles(void);    // Instruction cycles, compare with unsigned differences
+
+/* Non-blocking Delays (cycle counter, spans up to ~29 s) */
+uint32_t tmr_deadline_us(uint32_t us);   // Deadline us from now
+bool tmr_expired(uint32_t deadline);     // Deadline reached
+
+/*
+ * System tick: _T1Interrupt counts periods, tmr_tick_wait() keeps the CPU
+ * in Idle until the next one (any interrupt wakes it, only the tick ends
+ * the wait). Timer1 is reserved after tmr_tick_start().
+ */
+void tmr_tick_start(uint16_t ms);        // Start the periodic tick interrupt
+uint8_t tmr_tick_wait(void);             // Idle until the next tick, returns ticks already missed
+bool tmr_tick_next(uint32_t *due);       // tmr_cycles() the next tick is due, false if not started
+uint32_t tmr_tick_late(void);            // Cycles the last late tmr_tick_wait() was behind its tick
+uint16_t tmr_idle_permille(void);        // Idle time since the last call (0-1000)
 
 #ifdef __cplusplus
 }
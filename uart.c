@@ -5,10 +5,53 @@
 volatile UART_RxBuffer uart1_rx;
 volatile UART_TxBuffer uart1_tx;
 
+/* Command replies must not be lost: wait for ring space */
+UART_TxStream reply_stream = {
+    .policy = TX_BLOCK,
+    .timeout_ms = 20
+};
+
+/* Periodic reports are superseded by the next one: never wait for ring space */
+UART_TxStream report_stream = {
+    .policy = TX_DROP_NEWEST
+};
+
+/* Compute BRG for a baud divisor and return the error in per-mille */
+static uint32_t UART1_BaudError(uint32_t divisor, uint32_t baudrate, uint32_t *brg) {
+    uint32_t step = divisor * baudrate;
+    uint32_t n = (FCY + step / 2) / step;  // BRG + 1, rounded to nearest
+    
+    if (n == 0 || n > 65536UL) {
+        return UINT32_MAX;  // Not reachable with a 16-bit BRG
+    }
+    
+    uint32_t actual = FCY / (divisor * n);
+    uint32_t diff = (actual > baudrate) ? actual - baudrate : baudrate - actual;
+    *brg = n - 1;
+    return diff * 1000UL / baudrate;
+}
+
 /* Initialize UART1 peripheral */
-void UART1_Init(uint32_t baudrate) {
+bool UART1_Init(uint32_t baudrate) {
+    uint32_t brg_low = 0, brg_high = 0;
+    
+    if (baudrate == 0) {
+        return false;
+    }
+    
+    // Pick the divisor with the lower error; ties keep BRGH=0 (3x sampling)
+    uint32_t err_low = UART1_BaudError(16UL, baudrate, &brg_low);
+    uint32_t err_high = UART1_BaudError(4UL, baudrate, &brg_high);
+    bool high_speed = (err_high < err_low);
+    uint32_t err = high_speed ? err_high : err_low;
+    
+    if (err > UART_BAUD_TOL_PERMILLE) {
+        return false;  // Rate cannot be generated from FCY within tolerance
+    }
+    
     // Baud rate calculation 
-    U1BRG = (uint16_t)((FCY / (16UL * baudrate)) - 1);
+    U1MODEbits.BRGH = high_speed;
+    U1BRG = (uint16_t)(high_speed ? brg_high : brg_low);
     
     // UART control registers setup
     U1MODEbits.UARTEN = 1;   // Enable UART module
@@ -23,10 +66,28 @@ void UART1_Init(uint32_t baudrate) {
     IFS0bits.U1TXIF = 0;      // Clear transmit interrupt flag
     IFS0bits.U1RXIF = 0;      // Clear receive interrupt flag
     U1STAbits.URXISEL = 0b00; // Interrupt on every received character
+#if UART1_TX_USE_DMA
+    U1STAbits.UTXISEL0 = 0;   // Request a DMA transfer for every free FIFO slot
+    U1STAbits.UTXISEL1 = 0;
+#else
     U1STAbits.UTXISEL0 = 1;   // Interrupt when transmit buffer is empty
     U1STAbits.UTXISEL1 = 0;
+#endif
     IEC0bits.U1RXIE = 1;      // Enable receive interrupt
     IEC0bits.U1TXIE = 0;
+
+#if UART1_TX_USE_DMA
+    // DMA0: one-shot byte transfers from the TX ring into U1TXREG
+    DMA0CONbits.SIZE = 1;     // Byte transfers
+    DMA0CONbits.DIR = 1;      // RAM -> peripheral
+    DMA0CONbits.AMODE = 0b00; // Register indirect, post-increment
+    DMA0CONbits.MODE = 0b01;  // One-shot, ping-pong disabled
+    DMA0REQbits.IRQSEL = UART1_TX_DMA_IRQ;
+    DMA0PAD = (uint16_t)&U1TXREG;
+    IFS0bits.DMA0IF = 0;      // Clear block complete flag
+    IEC0bits.DMA0IE = 1;      // Enable block complete interrupt
+#endif
+    return true;
 }
 
 /* UART1 Receive Handler ----------------------------------------------------*/
@@ -35,32 +96,35 @@ void UART1_Init(uint32_t baudrate) {
 void UART1_RxBuffer_Init(volatile UART_RxBuffer *buf) {
     buf->head = 0;
     buf->tail = 0;
-    buf->overflow = false;
+    buf->overflow = 0;
+    buf->oerr = 0;
 }
 
-/* Function to write to the receive buffer */
+/* Function to write to the receive buffer (producer: RX ISR) */
 bool UART1_RxBuffer_Write(volatile UART_RxBuffer *buf, uint8_t data) {
-    uint16_t next_head = (buf->head + 1) % UART_RX_BUF_SIZE;
+    uint16_t head = buf->head;
     
-    // Always overwrite oldest data if full
-    if (next_head == buf->tail) {
-        buf->tail = (buf->tail + 1) % UART_RX_BUF_SIZE;  // Move tail forward
-        buf->overflow = true;  // Set overflow flag
+    // Drop the new byte if full: tail belongs to the consumer
+    if ((uint16_t)(head - buf->tail) == UART_RX_BUF_SIZE) {
+        buf->overflow++;       // Count dropped byte
+        return false;
     }
     
-    buf->buffer[buf->head] = data;
-    buf->head = next_head;
+    buf->buffer[head & UART_RX_BUF_MASK] = data;
+    buf->head = head + 1;  // Publish after the data is stored
     return true;
 }
 
-/* Function to read from the receive buffer */
+/* Function to read from the receive buffer (consumer: main loop) */
 bool UART1_RxBuffer_Read(volatile UART_RxBuffer *buf, uint8_t *data) {
-    if (buf->head == buf->tail) {
+    uint16_t tail = buf->tail;
+    
+    if (buf->head == tail) {
         return false;  // Buffer empty
     }
     
-    *data = buf->buffer[buf->tail];
-    buf->tail = (buf->tail + 1) % UART_RX_BUF_SIZE;
+    *data = buf->buffer[tail & UART_RX_BUF_MASK];
+    buf->tail = tail + 1;  // Release the slot after the data is read
     return true;
 }
 
@@ -71,13 +135,41 @@ bool UART1_RxBuffer_IsEmpty(volatile UART_RxBuffer *buf) {
 
 /* Function to check if the receive buffer is full */
 bool UART1_RxBuffer_IsFull(volatile UART_RxBuffer *buf) {
-    return ((buf->head + 1) % UART_RX_BUF_SIZE == buf->tail);
+    return ((uint16_t)(buf->head - buf->tail) == UART_RX_BUF_SIZE);
+}
+
+/* Function to get the filled spans of the receive buffer (0 if empty) */
+uint8_t UART1_RxBuffer_Peek(volatile UART_RxBuffer *buf, UART_Span span[2]) {
+    uint16_t tail = buf->tail;
+    uint16_t used = buf->head - tail;
+    uint16_t idx = tail & UART_RX_BUF_MASK;
+    uint16_t to_end = UART_RX_BUF_SIZE - idx;
+    
+    if (used == 0) {
+        return 0;  // Buffer empty
+    }
+    
+    span[0].ptr = (uint8_t *)&buf->buffer[idx];
+    if (used <= to_end) {
+        span[0].len = used;
+        return 1;
+    }
+    span[0].len = to_end;                       // Up to end of storage
+    span[1].ptr = (uint8_t *)&buf->buffer[0];   // Remainder from the start
+    span[1].len = used - to_end;
+    return 2;
+}
+
+/* Function to release len bytes returned by UART1_RxBuffer_Peek */
+void UART1_RxBuffer_Consume(volatile UART_RxBuffer *buf, uint16_t len) {
+    buf->tail = buf->tail + len;
 }
 
 // UART receive interrupt function
 void __attribute__((interrupt, auto_psv)) _U1RXInterrupt(void) {
     // Check for hardware error
     if (U1STAbits.OERR) {
+        uart1_rx.oerr++;
         U1STAbits.OERR = 0;  // Clear overrun error to allow new data
     }
     
@@ -95,32 +187,39 @@ void __attribute__((interrupt, auto_psv)) _U1RXInterrupt(void) {
 void UART1_TxBuffer_Init(volatile UART_TxBuffer *buf) {
     buf->head = 0;
     buf->tail = 0;
-    buf->overflow = false;
+    buf->overflow = 0;
+    buf->dma_len = 0;
+    buf->isr_count = 0;
+    buf->frame_start = 0;
+    buf->frame_head = 0;
+    buf->frame_tail = 0;
 }
 
-/* Function to write to the transmit buffer */
+/* Function to write to the transmit buffer (producer: main loop) */
 bool UART1_TxBuffer_Write(volatile UART_TxBuffer *buf, uint8_t data) {
-    uint16_t next_head = (buf->head + 1) % UART_TX_BUF_SIZE;
+    uint16_t head = buf->head;
     
-    // Overwrite oldest data if full
-    if (next_head == buf->tail) {
-        buf->tail = (buf->tail + 1) % UART_TX_BUF_SIZE;  // Move tail forward
-        buf->overflow = true;  // Set overflow flag
+    // Drop the new byte if full: tail belongs to the consumer
+    if ((uint16_t)(head - buf->tail) == UART_TX_BUF_SIZE) {
+        buf->overflow++;       // Count rejected write
+        return false;
     }
     
-    buf->buffer[buf->head] = data;
-    buf->head = next_head;
+    buf->buffer[head & UART_TX_BUF_MASK] = data;
+    buf->head = head + 1;  // Publish after the data is stored
     return true;
 }
 
-/* Function to read from the transmit buffer */
+/* Function to read from the transmit buffer (consumer: TX ISR) */
 bool UART1_TxBuffer_Read(volatile UART_TxBuffer *buf, uint8_t *data) {
-    if (buf->head == buf->tail) {
+    uint16_t tail = buf->tail;
+    
+    if (buf->head == tail) {
         return false;  // Buffer empty
     }
     
-    *data = buf->buffer[buf->tail];
-    buf->tail = (buf->tail + 1) % UART_TX_BUF_SIZE;
+    *data = buf->buffer[tail & UART_TX_BUF_MASK];
+    buf->tail = tail + 1;  // Release the slot after the data is read
     return true;
 }
 
@@ -131,12 +230,309 @@ bool UART1_TxBuffer_IsEmpty(volatile UART_TxBuffer *buf) {
 
 /* Function to check if the transmit buffer is full */
 bool UART1_TxBuffer_IsFull(volatile UART_TxBuffer *buf) {
-    return ((buf->head + 1) % UART_TX_BUF_SIZE == buf->tail);
+    return ((uint16_t)(buf->head - buf->tail) == UART_TX_BUF_SIZE);
+}
+
+/* Function to get the number of free bytes in the transmit buffer */
+uint16_t UART1_TxBuffer_Free(volatile UART_TxBuffer *buf) {
+    return UART_TX_BUF_SIZE - (uint16_t)(buf->head - buf->tail);
+}
+
+/* Function to get writable spans for len bytes (0 if not enough room) */
+uint8_t UART1_TxBuffer_Reserve(volatile UART_TxBuffer *buf, uint16_t len, UART_Span span[2]) {
+    uint16_t idx = buf->head & UART_TX_BUF_MASK;
+    uint16_t to_end = UART_TX_BUF_SIZE - idx;
+    
+    if (len == 0 || len > UART1_TxBuffer_Free(buf)) {
+        return 0;  // Nothing reserved
+    }
+    
+    span[0].ptr = (uint8_t *)&buf->buffer[idx];
+    if (len <= to_end) {
+        span[0].len = len;
+        return 1;
+    }
+    span[0].len = to_end;                       // Up to end of storage
+    span[1].ptr = (uint8_t *)&buf->buffer[0];   // Remainder from the start
+    span[1].len = len - to_end;
+    return 2;
+}
+
+/* Function to publish len bytes written into reserved spans */
+void UART1_TxBuffer_Commit(volatile UART_TxBuffer *buf, uint16_t len) {
+    buf->head = buf->head + len;
+}
+
+/* Mask the TX ring consumer, returning its previous enable state */
+static bool UART1_TxConsumer_Mask(void) {
+#if UART1_TX_USE_DMA
+    bool enabled = IEC0bits.DMA0IE;
+    IEC0bits.DMA0IE = 0;   // DMA keeps moving the armed span, tail is frozen
+#else
+    bool enabled = IEC0bits.U1TXIE;
+    IEC0bits.U1TXIE = 0;
+#endif
+    return enabled;
+}
+
+/* Restore the TX ring consumer interrupt */
+static void UART1_TxConsumer_Restore(bool enabled) {
+#if UART1_TX_USE_DMA
+    IEC0bits.DMA0IE = enabled;
+#else
+    IEC0bits.U1TXIE = enabled;
+#endif
+}
+
+/* Forget frames the consumer has fully taken out of the ring */
+static void UART1_TxFrames_Retire(volatile UART_TxBuffer *buf) {
+    uint16_t tail = buf->tail;
+    
+    while (buf->frame_tail != buf->frame_head) {
+        uint16_t end = buf->frame_end[buf->frame_tail & UART_TX_FRAME_MASK];
+        if ((int16_t)(tail - end) < 0) {
+            break;  // Still being sent
+        }
+        buf->frame_start = end;
+        buf->frame_tail++;
+    }
+}
+
+/* Check if a frame of len bytes can be queued right now */
+static bool UART1_TxFrames_Fits(volatile UART_TxBuffer *buf, uint16_t len) {
+    return (len <= UART1_TxBuffer_Free(buf)) &&
+           ((uint8_t)(buf->frame_head - buf->frame_tail) < UART_TX_FRAME_SLOTS);
+}
+
+/* First frame slot the consumer has not started on, with its start (consumer masked) */
+static uint8_t UART1_TxFrames_FirstQueued(volatile UART_TxBuffer *buf, uint16_t *start) {
+    uint16_t claimed = buf->tail + buf->dma_len;  // First byte not claimed by the consumer
+    uint8_t slot = buf->frame_tail;
+    
+    *start = buf->frame_start;
+    while (slot != buf->frame_head && (int16_t)(claimed - *start) > 0) {
+        *start = buf->frame_end[slot & UART_TX_FRAME_MASK];
+        slot++;
+    }
+    return slot;
+}
+
+/* Check if dropping every queued frame of stream makes room for len bytes */
+static bool UART1_TxFrames_CanMakeRoom(volatile UART_TxBuffer *buf, UART_TxStream *stream, uint16_t len) {
+    bool enabled = UART1_TxConsumer_Mask();
+    uint16_t start;
+    uint16_t freed = 0;
+    uint8_t frames = 0;
+    
+    for (uint8_t slot = UART1_TxFrames_FirstQueued(buf, &start); slot != buf->frame_head; slot++) {
+        uint16_t end = buf->frame_end[slot & UART_TX_FRAME_MASK];
+        if (buf->frame_stream[slot & UART_TX_FRAME_MASK] == stream) {
+            freed += end - start;
+            frames++;
+        }
+        start = end;
+    }
+    bool slots_ok = frames > 0 || (uint8_t)(buf->frame_head - buf->frame_tail) < UART_TX_FRAME_SLOTS;
+    bool room = slots_ok && len <= UART1_TxBuffer_Free(buf) + freed;
+    UART1_TxConsumer_Restore(enabled);
+    return room;
 }
 
+/*
+ * Discard the oldest queued frame of stream the consumer has not started
+ * on and close the gap by moving the later frames down. Other streams'
+ * frames are never touched. tail is never touched either, but the
+ * consumer is masked so the started/not-started boundary holds.
+ * Returns false if the stream has no droppable frame left.
+ */
+static bool UART1_TxFrames_DropOldest(volatile UART_TxBuffer *buf, UART_TxStream *stream) {
+    bool enabled = UART1_TxConsumer_Mask();
+    uint16_t start;
+    uint8_t slot = UART1_TxFrames_FirstQueued(buf, &start);
+    
+    // Skip frames of other streams
+    while (slot != buf->frame_head && buf->frame_stream[slot & UART_TX_FRAME_MASK] != stream) {
+        start = buf->frame_end[slot & UART_TX_FRAME_MASK];
+        slot++;
+    }
+    if (slot == buf->frame_head) {
+        UART1_TxConsumer_Restore(enabled);
+        return false;  // Nothing droppable
+    }
+    
+    uint16_t end = buf->frame_end[slot & UART_TX_FRAME_MASK];
+    uint16_t len = end - start;
+    
+    // Move every later byte down over the dropped frame
+    for (uint16_t i = end; i != buf->head; i++) {
+        buf->buffer[(uint16_t)(i - len) & UART_TX_BUF_MASK] = buf->buffer[i & UART_TX_BUF_MASK];
+    }
+    buf->head = buf->head - len;
+    
+    // Remove the slot and shift the later frame boundaries
+    for (uint8_t j = slot; (uint8_t)(j + 1) != buf->frame_head; j++) {
+        buf->frame_end[j & UART_TX_FRAME_MASK] = buf->frame_end[(uint8_t)(j + 1) & UART_TX_FRAME_MASK] - len;
+        buf->frame_stream[j & UART_TX_FRAME_MASK] = buf->frame_stream[(uint8_t)(j + 1) & UART_TX_FRAME_MASK];
+    }
+    buf->frame_head--;
+    UART1_TxConsumer_Restore(enabled);
+    
+    stream->frames_dropped++;
+    stream->bytes_dropped += len;
+    return true;
+}
+
+/* Function to reserve spans for a whole frame, applying the stream policy */
+uint8_t UART1_TxBuffer_ReserveFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream,
+                                    uint16_t len, UART_Span span[2]) {
+    if (len == 0) {
+        return 0;  // Nothing to queue
+    }
+    UART1_TxFrames_Retire(buf);
+    
+    if (len <= UART_TX_BUF_SIZE && !UART1_TxFrames_Fits(buf, len)) {
+        switch (stream->policy) {
+            case TX_DROP_OLDEST:
+                // Make room by discarding whole queued frames of this stream,
+                // if they cannot free enough the new frame is dropped instead
+                if (UART1_TxFrames_CanMakeRoom(buf, stream, len)) {
+                    while (!UART1_TxFrames_Fits(buf, len) && UART1_TxFrames_DropOldest(buf, stream));
+                }
+                break;
+                
+            case TX_BLOCK: {
+                // Let the transmitter drain for at most timeout_ms, and never into
+                // the guard before the next tick: the rest of the loop runs on time
+                uint32_t deadline = tmr_deadline_us((uint32_t)stream->timeout_ms * 1000);
+                uint32_t tick;
+                if (tmr_tick_next(&tick)) {
+                    tick -= (uint32_t)UART_TX_BLOCK_GUARD_US * TMR_CYCLES_PER_US;
+                    if ((int32_t)(tick - deadline) < 0) {
+                        deadline = tick;
+                    }
+                }
+                UART1_TxBuffer_Start(buf);
+                while (!tmr_expired(deadline)) {
+                    UART1_TxFrames_Retire(buf);
+                    if (UART1_TxFrames_Fits(buf, len)) {
+                        break;
+                    }
+                    Nop();
+                }
+                break;
+            }
+                
+            default:
+                break;
+        }
+    }
+    
+    uint8_t count = 0;
+    if (len <= UART_TX_BUF_SIZE && UART1_TxFrames_Fits(buf, len)) {
+        count = UART1_TxBuffer_Reserve(buf, len, span);
+    }
+    if (count == 0) {
+        // Drop newest: the frame never reaches the ring
+        stream->frames_dropped++;
+        stream->bytes_dropped += len;
+        buf->overflow++;
+    }
+    return count;
+}
+
+/* Function to publish a frame of len bytes written into reserved spans */
+void UART1_TxBuffer_CommitFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream, uint16_t len) {
+    uint8_t slot = buf->frame_head & UART_TX_FRAME_MASK;
+    
+    if (buf->frame_head == buf->frame_tail) {
+        buf->frame_start = buf->head;  // First queued frame starts here
+    }
+    buf->frame_end[slot] = buf->head + len;
+    buf->frame_stream[slot] = stream;
+    buf->frame_head++;
+    
+    UART1_TxBuffer_Commit(buf, len);
+    stream->frames_sent++;
+}
+
+/* Function to queue a whole frame, or nothing if the policy rejects it */
+bool UART1_TxBuffer_WriteFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream,
+                               const uint8_t *data, uint16_t len) {
+    UART_Span span[2];
+    uint8_t count = UART1_TxBuffer_ReserveFrame(buf, stream, len, span);
+    
+    if (count == 0) {
+        return false;
+    }
+    for (uint8_t i = 0; i < count; i++) {
+        memcpy(span[i].ptr, data, span[i].len);
+        data += span[i].len;
+    }
+    UART1_TxBuffer_CommitFrame(buf, stream, len);
+    return true;
+}
+
+/* Function to get the number of contiguous bytes starting at tail */
+uint16_t UART1_TxBuffer_Span(volatile UART_TxBuffer *buf) {
+    uint16_t tail = buf->tail;
+    uint16_t used = buf->head - tail;
+    uint16_t to_end = UART_TX_BUF_SIZE - (tail & UART_TX_BUF_MASK);
+    
+    return (used < to_end) ? used : to_end;  // Stop at the wrap point
+}
+
+#if UART1_TX_USE_DMA
+/* Hand the next contiguous span of the ring to DMA0 (channel must be idle) */
+static void UART1_TxDma_Load(volatile UART_TxBuffer *buf) {
+    uint16_t len = UART1_TxBuffer_Span(buf);
+    if (len == 0) {
+        return;  // Nothing queued
+    }
+    
+    buf->dma_len = len;
+    DMA0STAL = (uint16_t)&buf->buffer[buf->tail & UART_TX_BUF_MASK];  // Span start
+    DMA0STAH = 0;
+    DMA0CNT = len - 1;           // Transfer count is N-1
+    DMA0CONbits.CHEN = 1;        // Arm channel
+
+    // With room in the FIFO the TX event that would start the block may have
+    // passed already: force the first byte. A full FIFO requests it when a
+    // slot frees, and a forced write into it would be lost
+    if (!U1STAbits.UTXBF) {
+        DMA0REQbits.FORCE = 1;
+    }
+}
+
+/* Function to start transmission of queued data */
+void UART1_TxBuffer_Start(volatile UART_TxBuffer *buf) {
+    // An idle channel has no block-complete interrupt pending, so
+    // arming it here cannot race with _DMA0Interrupt
+    if (buf->dma_len == 0) {
+        UART1_TxDma_Load(buf);   // Idle: the ISR will chain the rest
+    }
+}
+
+/* DMA0 block complete: retire the span and chain the next one */
+void __attribute__((interrupt, no_auto_psv)) _DMA0Interrupt(void) {
+    IFS0bits.DMA0IF = 0;  // Clear the interrupt flag
+    uart1_tx.isr_count++;
+    
+    uart1_tx.tail = uart1_tx.tail + uart1_tx.dma_len;
+    uart1_tx.dma_len = 0;
+    UART1_TxDma_Load(&uart1_tx);
+}
+#else
+/* Function to start transmission of queued data */
+void UART1_TxBuffer_Start(volatile UART_TxBuffer *buf) {
+    IEC0bits.U1TXIE = 1;  // Enable TX interrupt
+    IFS0bits.U1TXIF = 1;  // Trigger transmission
+}
+#endif
+
 /* UART transmit interrupt function */
 void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void) {
     IFS0bits.U1TXIF = 0;  // Clear the interrupt flag first
+    uart1_tx.isr_count++;
 
     uint8_t data;
     // Fill the UART hardware FIFO as much as possible
@@ -153,3 +549,26 @@ void __attribute__((interrupt, no_auto_psv)) _U1TXInterrupt(void) {
         IEC0bits.U1TXIE = 0;  // Disable UART TX interrupt if buffer empty
     }
 }
+
+/* Text messages in a binary (COBS) byte stream are closed with 0x00 */
+static bool text_delimited = false;
+
+/* Function to select whether text messages end with a 0x00 delimiter */
+void UART1_SetTextDelimiter(bool enabled) {
+    text_delimited = enabled;
+}
+
+/* Function to queue a text message as one frame under the stream policy */
+bool UART1_SendText(UART_TxStream *stream, const char *str) {
+    // The string terminator doubles as the 0x00 delimiter
+    uint16_t len = strlen(str) + (text_delimited ? 1 : 0);
+    bool queued = UART1_TxBuffer_WriteFrame(&uart1_tx, stream, (const uint8_t *)str, len);
+    
+    UART1_TxBuffer_Start(&uart1_tx);   // Trigger transmission
+    return queued;
+}
+
+/* Helper function to send strings for replies and errors */
+void UART1_SendString(const char *str) {
+    UART1_SendText(&reply_stream, str);
+}
@@ -16,31 +16,100 @@ extern "C" {
 
 // Is buffer enough
 #define BAUDRATE            115200  // Default UART baud rate
+#define UART_BAUD_TOL_PERMILLE 20   // Max baud error accepted (2.0%)
+#define UART_BITS_PER_BYTE  10      // 8N1 framing: start + 8 data + stop
+#define UART_BYTES_PER_SEC  (BAUDRATE / UART_BITS_PER_BYTE)  // Link capacity
+
+// Baud generator: divisor 16 (BRGH=0) or 4 (BRGH=1), BRG rounded to nearest
+#define UART_BRG(div, baud)    (((FCY) + (div) * (baud) / 2) / ((div) * (baud)) - 1)
+#define UART_ACTUAL(div, baud) ((FCY) / ((div) * (UART_BRG(div, baud) + 1)))
+#define UART_ERR_PERMILLE(div, baud) \
+    ((UART_ACTUAL(div, baud) > (baud) ? UART_ACTUAL(div, baud) - (baud) \
+                                      : (baud) - UART_ACTUAL(div, baud)) * 1000 / (baud))
+
+// The default rate must be reachable with either BRGH setting
+STATIC_ASSERT(UART_ERR_PERMILLE(16UL, BAUDRATE) <= UART_BAUD_TOL_PERMILLE ||
+              UART_ERR_PERMILLE(4UL, BAUDRATE) <= UART_BAUD_TOL_PERMILLE, baudrate_error);
 #define UART_RX_BUF_SIZE    32      // Receive Circular buffer size
 #define UART_TX_BUF_SIZE    128      // Transmit Circular buffer size
+#define UART_RX_BUF_MASK    (UART_RX_BUF_SIZE - 1)  // Index mask (size is a power of two)
+#define UART_TX_BUF_MASK    (UART_TX_BUF_SIZE - 1)
+#define UART_TX_FRAME_SLOTS 16      // Queued frames tracked for drop-oldest
+#define UART_TX_FRAME_MASK  (UART_TX_FRAME_SLOTS - 1)
+#define UART_TX_BLOCK_GUARD_US 1000 // TX_BLOCK gives up this long before the next tick
+
+// Rings use free-running 16-bit indices masked on access
+STATIC_ASSERT((UART_RX_BUF_SIZE & UART_RX_BUF_MASK) == 0, rx_buf_size_pow2);
+STATIC_ASSERT((UART_TX_BUF_SIZE & UART_TX_BUF_MASK) == 0, tx_buf_size_pow2);
+STATIC_ASSERT((UART_TX_FRAME_SLOTS & UART_TX_FRAME_MASK) == 0, tx_frame_slots_pow2);
+
+// Transmit engine selection
+#define UART1_TX_USE_DMA     1      // 1: DMA0 moves ring spans, 0: byte-wise _U1TXInterrupt
+#define UART1_TX_ISR_REPORT  0      // 1: send $ISR,<entries/s>* once per second
+#define UART1_TX_DMA_IRQ     0x0C   // DMA request source: UART1 transmitter
     
+/*
+ * Both rings are single-producer/single-consumer: head is only written by
+ * the producer and tail only by the consumer, so neither side needs to mask
+ * the other's interrupt. RX: producer = _U1RXInterrupt, consumer = main loop.
+ * TX: producer = main loop, consumer = _U1TXInterrupt or _DMA0Interrupt.
+ */
+
+// Backpressure policy applied when a frame does not fit
+typedef enum {
+    TX_DROP_NEWEST = 0,   // Discard the frame being enqueued
+    TX_DROP_OLDEST,       // Discard own queued frames not yet started until it fits, else drop newest
+    TX_BLOCK              // Wait up to timeout_ms (at most until the tick guard) for space, then drop newest
+} UART_TxPolicy;
+
+// Telemetry stream: enqueue policy and loss accounting
+typedef struct {
+    UART_TxPolicy policy;                       // What to do when the ring is full
+    uint16_t timeout_ms;                        // TX_BLOCK wait limit
+    uint16_t frames_sent;                       // Frames enqueued
+    uint16_t frames_dropped;                    // Frames rejected or discarded
+    uint32_t bytes_dropped;                     // Bandwidth lost to drops
+} UART_TxStream;
+
 // RX Buffer Structure
 typedef struct {
     volatile uint8_t buffer[UART_RX_BUF_SIZE];  // Fixed-size storage
-    volatile uint16_t head;                     // Write position 
-    volatile uint16_t tail;                     // Read position
-    volatile bool overflow;                     // Overflow flag
+    volatile uint16_t head;                     // Write count (producer only)
+    volatile uint16_t tail;                     // Read count (consumer only)
+    volatile uint16_t overflow;                 // Bytes dropped, ring full (producer only)
+    volatile uint16_t oerr;                     // Hardware FIFO overruns (OERR)
 } UART_RxBuffer;
 
 // TX Buffer Structure
 typedef struct {
     volatile uint8_t buffer[UART_TX_BUF_SIZE];  // Fixed-size storage
-    volatile uint16_t head;                     // Write position
-    volatile uint16_t tail;                     // Read position
-    volatile bool overflow;                     // Overflow flag
+    volatile uint16_t head;                     // Write count (producer only)
+    volatile uint16_t tail;                     // Read count (consumer only)
+    volatile uint16_t overflow;                 // Writes/frames rejected (producer only)
+    volatile uint16_t dma_len;                  // Bytes handed to DMA, not yet retired
+    volatile uint16_t isr_count;                // TX ISR entries (free running)
+    // Frame boundaries, producer only (consumer never looks at them)
+    uint16_t frame_end[UART_TX_FRAME_SLOTS];    // Write count at the end of each frame
+    UART_TxStream *frame_stream[UART_TX_FRAME_SLOTS];  // Owner of each frame
+    uint16_t frame_start;                       // Write count at the oldest frame start
+    uint8_t frame_head;                         // Frame slots written
+    uint8_t frame_tail;                         // Frame slots retired
 } UART_TxBuffer;
 
+// Contiguous region inside a ring (a wrapped region takes two)
+typedef struct {
+    uint8_t *ptr;                               // First byte of the region
+    uint16_t len;                               // Region length in bytes
+} UART_Span;
+
 // Global Buffer Instances
 extern volatile UART_RxBuffer uart1_rx;
 extern volatile UART_TxBuffer uart1_tx;
+extern UART_TxStream reply_stream;      // Command replies and text messages
+extern UART_TxStream report_stream;     // Periodic reports ($CPU, $ISR), dropped when full
 
 // Initialization
-void UART1_Init(uint32_t baudrate);
+bool UART1_Init(uint32_t baudrate);  // Returns false if baudrate is out of tolerance
 
 // Buffer Operations
 void UART1_RxBuffer_Init(volatile UART_RxBuffer *buf);
@@ -50,11 +119,42 @@ bool UART1_RxBuffer_Read(volatile UART_RxBuffer *buf, uint8_t *data);
 bool UART1_TxBuffer_Write(volatile UART_TxBuffer *buf, uint8_t data);
 bool UART1_TxBuffer_Read(volatile UART_TxBuffer *buf, uint8_t *data);
 
+// Span Operations (zero-copy access, one or two spans per call)
+uint8_t UART1_TxBuffer_Reserve(volatile UART_TxBuffer *buf, uint16_t len, UART_Span span[2]);
+void UART1_TxBuffer_Commit(volatile UART_TxBuffer *buf, uint16_t len);
+uint8_t UART1_RxBuffer_Peek(volatile UART_RxBuffer *buf, UART_Span span[2]);
+void UART1_RxBuffer_Consume(volatile UART_RxBuffer *buf, uint16_t len);
+
+// Frame Operations (a frame is queued whole or not at all)
+uint8_t UART1_TxBuffer_ReserveFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream,
+                                    uint16_t len, UART_Span span[2]);
+void UART1_TxBuffer_CommitFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream, uint16_t len);
+bool UART1_TxBuffer_WriteFrame(volatile UART_TxBuffer *buf, UART_TxStream *stream,
+                               const uint8_t *data, uint16_t len);
+
 // Status Checks
 bool UART1_RxBuffer_IsEmpty(volatile UART_RxBuffer *buf);
 bool UART1_RxBuffer_IsFull(volatile UART_RxBuffer *buf);
 bool UART1_TxBuffer_IsEmpty(volatile UART_TxBuffer *buf);
 bool UART1_TxBuffer_IsFull(volatile UART_TxBuffer *buf);
+uint16_t UART1_TxBuffer_Free(volatile UART_TxBuffer *buf);
+
+// Transmit Engine
+uint16_t UART1_TxBuffer_Span(volatile UART_TxBuffer *buf);  // Contiguous bytes at tail
+void UART1_TxBuffer_Start(volatile UART_TxBuffer *buf);     // Kick transmission
+
+/*
+ * Text messages ($ACK, $ERR, $CPU, $STAT, ...) share the link with the
+ * binary telemetry. In binary mode every text message is closed with a
+ * 0x00 like a COBS frame, so a receiver splitting on 0x00 gets it whole:
+ * text starts with '$', a COBS frame with its code byte (at most
+ * TLM_PAYLOAD_MAX + 1, never '$').
+ */
+void UART1_SetTextDelimiter(bool enabled);                   // True while telemetry is binary
+bool UART1_SendText(UART_TxStream *stream, const char *str); // Queue a text message as one frame
+
+// Helper Function
+void UART1_SendString(const char *str);  // UART1_SendText on the reply stream
 
 #ifdef __cplusplus
 }